@@ -0,0 +1,231 @@
+#ifndef MSDF_ADVANCE_INDEX_H
+#define MSDF_ADVANCE_INDEX_H
+
+// Prefix sums of the kerned pen advance along one line of text: entry i is
+// the pen x where codepoint i is placed, the last entry (one past the last
+// codepoint) is the line width. With the sums at hand, caret placement,
+// hit testing and fitting a line into a width are binary searches instead
+// of another pass over the glyphs.
+//
+// The sums come either from layout (LayoutTarget::pens, in layout
+// coordinates) or from AdvanceIndex::build(), an advance-only pass starting
+// at x = 0 that reads ASCII straight from the font's AsciiMetrics. Both
+// accumulate exactly like layoutText(). The searches assume the sums never
+// decrease, i.e. no kerning pair pulls the pen back past the glyph before.
+//
+// "..." truncation of a single long label does not need the index at all:
+// ellipsizeText() stops scanning as soon as the line is known to overflow.
+
+#include <msdf_font.h>
+#include <msdf_glyph_store.h>
+#include <msdf_text_layout.h>
+#include <msdf_utf8.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// searches over a span of `count` prefix sums (codepoints + 1)
+
+// the caret boundary nearest to x
+inline size_t advanceCaret(const float* pens, size_t count, float x) {
+    size_t next = (size_t)(std::lower_bound(pens, pens + count, x) - pens);
+    if (next == 0)
+        return 0;
+    if (next == count)
+        return count - 1;
+    return x - pens[next - 1] < pens[next] - x ? next - 1 : next;
+}
+
+// the codepoint whose advance covers x; count - 1 (past the end) right of the line
+inline size_t advanceCharAt(const float* pens, size_t count, float x) {
+    size_t next = (size_t)(std::upper_bound(pens, pens + count, x) - pens);
+    return next == 0 ? 0 : next - 1;
+}
+
+// how many leading codepoints fit, advance included, into `width`
+inline size_t advanceFit(const float* pens, size_t count, float width) {
+    if (count == 0)
+        return 0;
+    size_t end = (size_t)(std::upper_bound(pens, pens + count, pens[0] + width) - pens);
+    return end == 0 ? 0 : end - 1;
+}
+
+// result of fitting a line into a width with a trailing ellipsis
+struct Ellipsis {
+    size_t bytes = 0;                   // UTF-8 bytes of the text to keep
+    size_t codepoints = 0;
+    bool truncated = false;             // lay out the kept text followed by ellipsisMark()
+    float width = 0.0f;                 // kept text plus the mark when truncated
+};
+
+// U+2026 where the font has it, "..." otherwise
+inline std::string_view ellipsisMark(const Font& font) {
+    if (font.atlas().glyphTable().lookup(0x2026) != GLYPH_MISSING)
+        return "\xE2\x80\xA6";
+    return "...";
+}
+
+inline float ellipsisWidth(const Font& font, float scale) {
+    return measureText(font, ellipsisMark(font), scale).width;
+}
+
+// the prefix advance index of one line ('\n' is an ordinary codepoint here)
+class AdvanceIndex
+{
+public:
+    // ------------------------------------------------------------------------
+    void build(const Font& font, std::string_view text, float scale)
+    {
+        const GlyphStore& glyphs = font.glyphs();
+        const AsciiMetrics& ascii = font.asciiMetrics();
+        const size_t NON_ASCII = ASCII_ROW_START + 1;
+
+        pens.resize(text.size() + 1);
+        offsets.clear();
+        float* out = pens.data();
+        float x = 0.0f;
+        uint16_t prev_glyph = GLYPH_MISSING;
+        size_t row = ascii.usable() ? ASCII_ROW_START : NON_ASCII;
+
+        const unsigned char* begin = reinterpret_cast<const unsigned char*>(text.data());
+        const unsigned char* in = begin;
+        const unsigned char* end = in + text.size();
+        while (in < end) {
+            if (*in < 0x80 && row != NON_ASCII) {
+                float pen = x;
+                size_t previous = row;
+                for (; in < end && *in < 0x80; ++in) {
+                    if (!offsets.empty())
+                        offsets.push_back((uint32_t)(in - begin));
+                    *out++ = pen;
+                    pen += ascii.advance(previous, *in) * scale;
+                    previous = *in;
+                }
+                x = pen;
+                row = previous;
+                continue;
+            }
+            if (row < ASCII_ROW_START)
+                prev_glyph = ascii.glyph((uint32_t)row);
+
+            // byte offsets are kept from the first multi-byte sequence on;
+            // before it a codepoint's index is its offset
+            if (offsets.empty() && *in >= 0x80)
+                for (size_t i = 0; i <= (size_t)(in - begin); ++i)
+                    offsets.push_back((uint32_t)i);
+            else if (!offsets.empty())
+                offsets.push_back((uint32_t)(in - begin));
+
+            uint32_t codepoint = utf8DecodeOne(in, end);
+            *out++ = x;
+            uint16_t glyph = font.glyphIndex(codepoint);
+            if (glyph != GLYPH_MISSING) {
+                x += glyphs.advance(prev_glyph, glyph) * scale;
+                prev_glyph = glyph;
+            }
+            row = (codepoint < 0x80 && ascii.usable()) ? codepoint : NON_ASCII;
+        }
+        *out++ = x;
+        pens.resize((size_t)(out - pens.data()));
+        if (!offsets.empty())
+            offsets.push_back((uint32_t)text.size());
+        text_bytes = text.size();
+    }
+
+    size_t size() const { return pens.empty() ? 0 : pens.size() - 1; }   // codepoints
+    float width() const { return pens.empty() ? 0.0f : pens.back(); }
+    const float* data() const { return pens.data(); }
+
+    // character -> x: pen offset of codepoint `index`, width() at size()
+    float penX(size_t index) const { return pens[std::min(index, size())]; }
+    // x -> nearest caret position in [0, size()]
+    size_t caretAt(float x) const { return advanceCaret(pens.data(), pens.size(), x); }
+    // x -> codepoint under x, size() right of the line
+    size_t charAt(float x) const { return advanceCharAt(pens.data(), pens.size(), x); }
+    // leading codepoints that fit into `width`
+    size_t fitCount(float width) const { return advanceFit(pens.data(), pens.size(), width); }
+    bool fits(float width) const { return this->width() <= width; }
+
+    // UTF-8 offset of codepoint `index`, the text size at size()
+    size_t byteOffset(size_t index) const
+    {
+        if (offsets.empty())
+            return std::min(index, text_bytes);
+        return offsets[std::min(index, size())];
+    }
+
+    // keep as much as fits into maxWidth together with a mark `markWidth` wide
+    // (ellipsisWidth()); nothing is cut when the whole line fits
+    // ------------------------------------------------------------------------
+    Ellipsis ellipsize(float maxWidth, float markWidth) const
+    {
+        Ellipsis result;
+        if (size() == 0 || fits(maxWidth)) {
+            result.codepoints = size();
+            result.bytes = byteOffset(size());
+            result.width = width();
+            return result;
+        }
+        result.truncated = true;
+        result.codepoints = maxWidth >= markWidth ? fitCount(maxWidth - markWidth) : 0;
+        result.bytes = byteOffset(result.codepoints);
+        result.width = penX(result.codepoints) + markWidth;
+        return result;
+    }
+
+private:
+    std::vector<float> pens;            // size() + 1 prefix sums
+    std::vector<uint32_t> offsets;      // size() + 1 byte offsets; empty for ASCII text
+    size_t text_bytes = 0;
+};
+
+// one-shot "..." truncation without an index: the advances are summed only
+// until the line overflows maxWidth, so a 10k character line cut to a label
+// costs about as much as the part that stays visible
+// ------------------------------------------------------------------------
+inline Ellipsis ellipsizeText(const Font& font, std::string_view text, float scale, float maxWidth) {
+    const GlyphStore& glyphs = font.glyphs();
+    const float mark_width = ellipsisWidth(font, scale);
+    const float keep_width = maxWidth - mark_width;
+
+    Ellipsis result;
+    float x = 0.0f;
+    uint16_t prev_glyph = GLYPH_MISSING;
+    const unsigned char* begin = reinterpret_cast<const unsigned char*>(text.data());
+    const unsigned char* in = begin;
+    const unsigned char* end = in + text.size();
+    size_t codepoints = 0;
+    bool kept = false;
+    while (in < end) {
+        const unsigned char* at = in;
+        uint32_t codepoint = utf8DecodeOne(in, end);
+        uint16_t glyph = font.glyphIndex(codepoint);
+        float next = glyph != GLYPH_MISSING ? x + glyphs.advance(prev_glyph, glyph) * scale : x;
+        if (!kept && next > keep_width) {
+            // the last point where the mark still fits, used if the line overflows later
+            kept = true;
+            result.bytes = (size_t)(at - begin);
+            result.codepoints = codepoints;
+            result.width = x + mark_width;
+        }
+        if (next > maxWidth) {
+            result.truncated = true;
+            break;
+        }
+        if (glyph != GLYPH_MISSING)
+            prev_glyph = glyph;
+        x = next;
+        ++codepoints;
+    }
+    if (!result.truncated) {
+        result.bytes = text.size();
+        result.codepoints = codepoints;
+        result.width = x;
+    }
+    return result;
+}
+
+#endif
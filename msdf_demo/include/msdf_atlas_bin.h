@@ -0,0 +1,740 @@
+#ifndef MSDF_ATLAS_BIN_H
+#define MSDF_ATLAS_BIN_H
+
+// Precompiled binary atlas (*.atlas), the runtime replacement for parsing the
+// msdf-atlas-gen JSON on every start. Modelled on RNDR_load_atlas reading
+// rndr_atlas_prj_gen.atlas: the file is compiled offline, mapped read-only at
+// runtime and its glyph/kerning tables are used in place.
+//
+// File layout (little endian, every table starts on a 16 byte boundary):
+//   AtlasBinHeader
+//   AtlasBinGlyph   glyphs[glyph_count]     sorted by codepoint
+//   AtlasBinKerning kerning[kerning_count]  sorted by (left, right)
+//   AtlasBinPage    pages[page_count]
+//   char            strings[strings_size]   page image paths, NUL terminated
+//
+// Every glyph carries the run of kerning pairs it is the left side of
+// (kerning_first, kerning_count), so an unkerned left glyph costs one field
+// test; AtlasFile adds a bitmap of the glyphs that are the right side of some
+// pair, so most kerned left glyphs skip their run as well.
+//
+// All lengths (advance, plane bounds, kerning, line metrics) are already
+// multiplied by the atlas font size, so they are in atlas pixels; layout only
+// has to apply its own scale. UVs are already divided by the width/height of
+// the glyph's page and measured from the bottom row: only atlases generated
+// with yOrigin "bottom" are compiled, and the pages are flipped on upload.
+//
+// An atlas can span several texture pages (one msdf-atlas-gen JSON/PNG pair
+// per page, merged by the compiler); every glyph records its page so pages
+// can be loaded only when text uses them (see msdf_atlas_pages.h).
+//
+// The header records the size and hash of the source JSON, so a runtime that
+// still has the JSON next to the atlas recompiles a stale binary.
+
+#include <nlohmann/json.hpp>
+#include <msdf_glyph_table.h>
+#include <msdf_hash.h>
+#include <msdf_mapped_file.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+
+const uint32_t ATLAS_BIN_MAGIC   = 0x4144534D; // "MSDA"
+const uint32_t ATLAS_BIN_VERSION = 4;
+const uint32_t ATLAS_BIN_ALIGN   = 16;
+
+enum AtlasBinType : uint32_t {
+    ATLAS_TYPE_HARDMASK = 0,
+    ATLAS_TYPE_SOFTMASK,
+    ATLAS_TYPE_SDF,
+    ATLAS_TYPE_PSDF,
+    ATLAS_TYPE_MSDF,
+    ATLAS_TYPE_MTSDF
+};
+
+const uint32_t ATLAS_BIN_MAX_PAGES = 256;
+const uint32_t ATLAS_BIN_MAX_GLYPH_KERNING = 0xFFFF;    // pairs per left glyph, AtlasBinGlyph::kerning_count
+
+// glyph flags
+const uint8_t ATLAS_GLYPH_VISIBLE = 0x1;    // has plane/atlas bounds, emits a quad
+
+struct AtlasBinHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t header_size;
+    uint32_t file_size;
+
+    uint32_t type;              // AtlasBinType
+    uint32_t y_origin_bottom;   // always 1: atlas rows start at the bottom
+    float    distance_range;
+    float    font_size;         // "atlas.size": pixels per em
+
+    float    atlas_width;
+    float    atlas_height;
+    float    line_height;       // pixels
+    float    ascender;          // pixels
+
+    float    descender;         // pixels
+    float    underline_y;       // pixels
+    float    underline_thickness;
+    uint32_t reserved0;
+
+    uint32_t glyph_count;
+    uint32_t glyph_offset;
+    uint32_t kerning_count;
+    uint32_t kerning_offset;
+
+    uint32_t page_count;
+    uint32_t page_offset;
+    uint32_t strings_size;
+    uint32_t strings_offset;
+
+    uint64_t source_hash;       // hashBytes64() of the source JSON; of the per-page hashes for several pages
+    uint64_t source_size;       // bytes, summed over the pages
+};
+
+struct AtlasBinGlyph {
+    uint32_t codepoint;
+    uint8_t  flags;
+    uint8_t  page;                  // texture page holding the glyph
+    uint16_t kerning_count;         // pairs with this glyph on the left
+    float    advance;               // pixels
+    float    pl, pb, pr, pt;        // plane bounds, pixels relative to the pen
+    float    u0, v0, u1, v1;        // normalized atlas rect
+    uint32_t kerning_first;         // index of the first pair in the kerning table
+};
+
+struct AtlasBinKerning {
+    uint32_t left;
+    uint32_t right;
+    float    advance;               // pixels
+    uint32_t reserved;
+};
+
+struct AtlasBinPage {
+    uint32_t image_offset;          // page image path, offset into the string table
+    uint32_t image_length;
+    uint32_t width;
+    uint32_t height;
+};
+
+static_assert(sizeof(AtlasBinHeader) % ATLAS_BIN_ALIGN == 0, "AtlasBinHeader must keep the tables aligned");
+static_assert(sizeof(AtlasBinGlyph) == 48, "AtlasBinGlyph layout is part of the file format");
+static_assert(sizeof(AtlasBinKerning) == 16, "AtlasBinKerning layout is part of the file format");
+static_assert(sizeof(AtlasBinPage) == 16, "AtlasBinPage layout is part of the file format");
+
+// orders kerning pairs by their left codepoint, for searches by codepoint
+struct AtlasBinKerningLeft {
+    bool operator()(const AtlasBinKerning& pair, uint32_t codepoint) const { return pair.left < codepoint; }
+    bool operator()(uint32_t codepoint, const AtlasBinKerning& pair) const { return codepoint < pair.left; }
+};
+
+inline uint32_t atlasBinAlign(uint32_t offset) {
+    return (offset + ATLAS_BIN_ALIGN - 1) & ~(ATLAS_BIN_ALIGN - 1);
+}
+
+// offline compiler
+// ------------------------------------------------------------------------
+
+// one texture page of the source description
+struct AtlasBinPageSource {
+    std::string image;
+    uint32_t width;
+    uint32_t height;
+};
+
+// decoded atlas description, the input of writeAtlasBinary()
+struct AtlasBinSource {
+    AtlasBinHeader header;
+    std::vector<AtlasBinGlyph> glyphs;
+    std::vector<AtlasBinKerning> kerning;
+    std::vector<AtlasBinPageSource> pages;
+};
+
+// image of a msdf-atlas-gen JSON description: same path, ".png" extension
+inline std::string atlasImageForJson(const std::string& jsonPath) {
+    size_t dot = jsonPath.find_last_of('.');
+    size_t slash = jsonPath.find_last_of("/\\");
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+        return jsonPath + ".png";
+    return jsonPath.substr(0, dot) + ".png";
+}
+
+inline uint32_t atlasBinTypeFromString(const std::string& type) {
+    if (type == "hardmask") return ATLAS_TYPE_HARDMASK;
+    if (type == "softmask") return ATLAS_TYPE_SOFTMASK;
+    if (type == "sdf")      return ATLAS_TYPE_SDF;
+    if (type == "psdf")     return ATLAS_TYPE_PSDF;
+    if (type == "mtsdf")    return ATLAS_TYPE_MTSDF;
+    return ATLAS_TYPE_MSDF;
+}
+
+// sort the tables, link every glyph to its kerning run and fill in counts
+// and offsets; false when the tables do not fit the format
+inline bool finalizeAtlasBinSource(AtlasBinSource& source) {
+    if (source.glyphs.size() > GLYPH_MAX_COUNT) {
+        std::cout << "ERROR::ATLAS::TOO_MANY_GLYPHS: " << source.glyphs.size() << " (at most " << GLYPH_MAX_COUNT << ")" << std::endl;
+        return false;
+    }
+    std::sort(source.glyphs.begin(), source.glyphs.end(),
+        [](const AtlasBinGlyph& a, const AtlasBinGlyph& b) { return a.codepoint < b.codepoint; });
+    std::sort(source.kerning.begin(), source.kerning.end(),
+        [](const AtlasBinKerning& a, const AtlasBinKerning& b) {
+            return a.left != b.left ? a.left < b.left : a.right < b.right;
+        });
+
+    for (AtlasBinGlyph& glyph : source.glyphs) {
+        auto run = std::equal_range(source.kerning.begin(), source.kerning.end(), glyph.codepoint, AtlasBinKerningLeft());
+        size_t count = run.second - run.first;
+        if (count > ATLAS_BIN_MAX_GLYPH_KERNING) {
+            std::cout << "ERROR::ATLAS::TOO_MANY_KERNING_PAIRS: U+" << std::hex << glyph.codepoint << std::dec
+                      << " has " << count << " (at most " << ATLAS_BIN_MAX_GLYPH_KERNING << ")" << std::endl;
+            return false;
+        }
+        glyph.kerning_first = (uint32_t)(run.first - source.kerning.begin());
+        glyph.kerning_count = (uint16_t)count;
+    }
+
+    AtlasBinHeader& header = source.header;
+    header.magic = ATLAS_BIN_MAGIC;
+    header.version = ATLAS_BIN_VERSION;
+    header.header_size = sizeof(AtlasBinHeader);
+    header.glyph_count = (uint32_t)source.glyphs.size();
+    header.glyph_offset = atlasBinAlign(header.header_size);
+    header.kerning_count = (uint32_t)source.kerning.size();
+    header.kerning_offset = atlasBinAlign(header.glyph_offset + header.glyph_count * (uint32_t)sizeof(AtlasBinGlyph));
+    header.page_count = (uint32_t)source.pages.size();
+    header.page_offset = atlasBinAlign(header.kerning_offset + header.kerning_count * (uint32_t)sizeof(AtlasBinKerning));
+    header.strings_size = 0;
+    for (const AtlasBinPageSource& page : source.pages)
+        header.strings_size += (uint32_t)page.image.size() + 1;
+    header.strings_offset = header.page_offset + header.page_count * (uint32_t)sizeof(AtlasBinPage);
+    header.file_size = header.strings_offset + header.strings_size;
+    return true;
+}
+
+// streaming reader for the msdf-atlas-gen JSON: a SAX handler that fills the
+// glyph and kerning tables as tokens arrive, so no DOM is ever built and the
+// working set is the tables themselves. Values are collected in JSON units
+// (em / atlas pixels) and converted by readAtlasJson() once "atlas.size" and
+// the atlas dimensions are known, whatever order the sections come in.
+class AtlasJsonSax : public nlohmann::json_sax<nlohmann::json>
+{
+public:
+    explicit AtlasJsonSax(AtlasBinSource& source) : source(source)
+    {
+        memset(&source.header, 0, sizeof(source.header));
+        source.header.type = ATLAS_TYPE_MSDF;
+        source.header.y_origin_bottom = 1;
+        source.glyphs.clear();
+        source.kerning.clear();
+    }
+
+    std::string error;
+
+    bool null() override { return true; }
+    bool boolean(bool) override { return true; }
+    bool number_integer(number_integer_t val) override { return number((double)val); }
+    bool number_unsigned(number_unsigned_t val) override { return number((double)val); }
+    bool number_float(number_float_t val, const string_t&) override { return number((double)val); }
+    bool binary(binary_t&) override { return true; }
+    // ------------------------------------------------------------------------
+    bool string(string_t& val) override
+    {
+        if (depth == 2 && section == SECTION_ATLAS) {
+            if (key_name == "type")
+                source.header.type = atlasBinTypeFromString(val);
+            else if (key_name == "yOrigin")
+                source.header.y_origin_bottom = (val == "bottom") ? 1 : 0;
+        }
+        return true;
+    }
+    // ------------------------------------------------------------------------
+    bool start_object(std::size_t) override
+    {
+        ++depth;
+        if (depth == 2 && section == SECTION_GLYPHS) {
+            memset(&glyph, 0, sizeof(glyph));
+            bounds_seen = 0;
+        }
+        else if (depth == 2 && section == SECTION_KERNING) {
+            memset(&pair, 0, sizeof(pair));
+        }
+        else if (depth == 3 && section == SECTION_GLYPHS) {
+            bounds = (key_name == "planeBounds") ? BOUNDS_PLANE
+                   : (key_name == "atlasBounds") ? BOUNDS_ATLAS : BOUNDS_NONE;
+            if (bounds != BOUNDS_NONE)
+                bounds_seen |= bounds;
+        }
+        return true;
+    }
+    // ------------------------------------------------------------------------
+    bool end_object() override
+    {
+        if (depth == 2 && section == SECTION_GLYPHS) {
+            if (bounds_seen == (BOUNDS_PLANE | BOUNDS_ATLAS))
+                glyph.flags |= ATLAS_GLYPH_VISIBLE;
+            source.glyphs.push_back(glyph);
+        }
+        else if (depth == 2 && section == SECTION_KERNING) {
+            source.kerning.push_back(pair);
+        }
+        else if (depth == 3) {
+            bounds = BOUNDS_NONE;
+        }
+        else if (depth == 2 && (section == SECTION_ATLAS || section == SECTION_METRICS)) {
+            section = SECTION_NONE;
+        }
+        --depth;
+        return true;
+    }
+    // ------------------------------------------------------------------------
+    bool start_array(std::size_t) override
+    {
+        if (depth == 1)
+            section = (key_name == "glyphs") ? SECTION_GLYPHS
+                    : (key_name == "kerning") ? SECTION_KERNING : SECTION_OTHER;
+        return true;
+    }
+    bool end_array() override
+    {
+        if (depth == 1)
+            section = SECTION_NONE;
+        return true;
+    }
+    // ------------------------------------------------------------------------
+    bool key(string_t& val) override
+    {
+        if (depth == 1)
+            section = (val == "atlas") ? SECTION_ATLAS
+                    : (val == "metrics") ? SECTION_METRICS : SECTION_OTHER;
+        key_name = val;
+        return true;
+    }
+    // ------------------------------------------------------------------------
+    bool parse_error(std::size_t position, const std::string&, const nlohmann::detail::exception& ex) override
+    {
+        error = std::string(ex.what()) + " at byte " + std::to_string(position);
+        return false;
+    }
+
+private:
+    enum Section { SECTION_NONE, SECTION_ATLAS, SECTION_METRICS, SECTION_GLYPHS, SECTION_KERNING, SECTION_OTHER };
+    enum Bounds { BOUNDS_NONE = 0, BOUNDS_PLANE = 1, BOUNDS_ATLAS = 2 };
+
+    AtlasBinSource& source;
+    std::string key_name;
+    int depth = 0;
+    Section section = SECTION_NONE;
+    Bounds bounds = BOUNDS_NONE;
+    int bounds_seen = 0;
+    AtlasBinGlyph glyph;
+    AtlasBinKerning pair;
+
+    // ------------------------------------------------------------------------
+    bool number(double val)
+    {
+        AtlasBinHeader& header = source.header;
+        float f = (float)val;
+        if (depth == 2 && section == SECTION_ATLAS) {
+            if (key_name == "size") header.font_size = f;
+            else if (key_name == "width") header.atlas_width = f;
+            else if (key_name == "height") header.atlas_height = f;
+            else if (key_name == "distanceRange") header.distance_range = f;
+        }
+        else if (depth == 2 && section == SECTION_METRICS) {
+            if (key_name == "lineHeight") header.line_height = f;
+            else if (key_name == "ascender") header.ascender = f;
+            else if (key_name == "descender") header.descender = f;
+            else if (key_name == "underlineY") header.underline_y = f;
+            else if (key_name == "underlineThickness") header.underline_thickness = f;
+        }
+        else if (depth == 2 && section == SECTION_GLYPHS) {
+            if (key_name == "unicode") glyph.codepoint = (uint32_t)val;
+            else if (key_name == "advance") glyph.advance = f;
+        }
+        else if (depth == 3 && section == SECTION_GLYPHS && bounds == BOUNDS_PLANE) {
+            if (key_name == "left") glyph.pl = f;
+            else if (key_name == "bottom") glyph.pb = f;
+            else if (key_name == "right") glyph.pr = f;
+            else if (key_name == "top") glyph.pt = f;
+        }
+        else if (depth == 3 && section == SECTION_GLYPHS && bounds == BOUNDS_ATLAS) {
+            if (key_name == "left") glyph.u0 = f;
+            else if (key_name == "bottom") glyph.v0 = f;
+            else if (key_name == "right") glyph.u1 = f;
+            else if (key_name == "top") glyph.v1 = f;
+        }
+        else if (depth == 2 && section == SECTION_KERNING) {
+            if (key_name == "unicode1") pair.left = (uint32_t)val;
+            else if (key_name == "unicode2") pair.right = (uint32_t)val;
+            else if (key_name == "advance") pair.advance = f;
+        }
+        return true;
+    }
+};
+
+// parse statistics reported by readAtlasJson()
+struct AtlasParseStats {
+    size_t bytes = 0;
+    double milliseconds = 0.0;
+    double megabytesPerSecond() const { return milliseconds > 0.0 ? (bytes / (1024.0 * 1024.0)) / (milliseconds / 1000.0) : 0.0; }
+};
+
+// read a msdf-atlas-gen JSON description (atlas, metrics, glyphs, kerning)
+inline bool readAtlasJson(const std::string& jsonPath, AtlasBinSource& source, AtlasParseStats* stats = nullptr) {
+    std::ifstream inputFile(jsonPath, std::ios::binary);
+    if (!inputFile.is_open()) {
+        std::cout << "ERROR::ATLAS::FILE_NOT_SUCCESSFULLY_READ: " << jsonPath << std::endl;
+        return false;
+    }
+    inputFile.seekg(0, std::ios::end);
+    size_t bytes = (size_t)inputFile.tellg();
+    inputFile.seekg(0, std::ios::beg);
+
+    auto start = std::chrono::steady_clock::now();
+    AtlasJsonSax handler(source);
+    if (!nlohmann::json::sax_parse(inputFile, &handler)) {
+        std::cout << "ERROR::ATLAS::JSON_PARSE_FAILED: " << handler.error << std::endl;
+        return false;
+    }
+
+    AtlasBinHeader& header = source.header;
+    if (!header.y_origin_bottom) {
+        std::cout << "ERROR::ATLAS::Y_ORIGIN_TOP: " << jsonPath << " (generate it with -yorigin bottom)" << std::endl;
+        return false;
+    }
+    if (header.font_size <= 0.0f || header.atlas_width <= 0.0f || header.atlas_height <= 0.0f) {
+        std::cout << "ERROR::ATLAS::MISSING_ATLAS_SIZE: " << jsonPath << std::endl;
+        return false;
+    }
+
+    // JSON units -> atlas pixels / normalized UVs
+    float font_size = header.font_size;
+    header.line_height *= font_size;
+    header.ascender *= font_size;
+    header.descender *= font_size;
+    header.underline_y *= font_size;
+    header.underline_thickness *= font_size;
+
+    for (AtlasBinGlyph& glyph : source.glyphs) {
+        glyph.advance *= font_size;
+        if (glyph.flags & ATLAS_GLYPH_VISIBLE) {
+            glyph.pl *= font_size;
+            glyph.pb *= font_size;
+            glyph.pr *= font_size;
+            glyph.pt *= font_size;
+            glyph.u0 /= header.atlas_width;
+            glyph.v0 /= header.atlas_height;
+            glyph.u1 /= header.atlas_width;
+            glyph.v1 /= header.atlas_height;
+        }
+        else {
+            glyph.pl = glyph.pb = glyph.pr = glyph.pt = 0.0f;
+            glyph.u0 = glyph.v0 = glyph.u1 = glyph.v1 = 0.0f;
+        }
+    }
+    for (AtlasBinKerning& pair : source.kerning)
+        pair.advance *= font_size;
+
+    source.pages.clear();
+    source.pages.push_back({ atlasImageForJson(jsonPath), (uint32_t)header.atlas_width, (uint32_t)header.atlas_height });
+    if (!finalizeAtlasBinSource(source))
+        return false;
+
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    AtlasParseStats local;
+    AtlasParseStats& result = stats ? *stats : local;
+    result.bytes = bytes;
+    result.milliseconds = elapsed.count();
+    std::cout << "ATLAS::PARSE: " << jsonPath << " " << bytes << " bytes in " << result.milliseconds
+              << " ms (" << result.megabytesPerSecond() << " MB/s), "
+              << source.glyphs.size() << " glyphs, " << source.kerning.size() << " kerning pairs" << std::endl;
+    return true;
+}
+
+// read several msdf-atlas-gen JSON descriptions as the pages of one atlas.
+// Page i holds the glyphs of jsonPaths[i]; a codepoint present on several
+// pages is taken from the first one. Font metrics come from the first page,
+// kerning pairs are merged; every page must have the first page's font size.
+inline bool readAtlasJsonPages(const std::vector<std::string>& jsonPaths, AtlasBinSource& source) {
+    if (jsonPaths.empty() || jsonPaths.size() > ATLAS_BIN_MAX_PAGES) {
+        std::cout << "ERROR::ATLAS::PAGE_COUNT: " << jsonPaths.size() << std::endl;
+        return false;
+    }
+    if (!readAtlasJson(jsonPaths[0], source))
+        return false;
+
+    for (size_t i = 1; i < jsonPaths.size(); ++i) {
+        AtlasBinSource page;
+        if (!readAtlasJson(jsonPaths[i], page))
+            return false;
+        if (page.header.font_size != source.header.font_size) {
+            // plane bounds and advances are stored in atlas pixels of each
+            // page's own size: merged, the pages would lay out at different scales
+            std::cout << "ERROR::ATLAS::PAGE_FONT_SIZE_MISMATCH: " << jsonPaths[i] << " has size " << page.header.font_size
+                      << ", " << jsonPaths[0] << " has " << source.header.font_size << std::endl;
+            return false;
+        }
+
+        for (AtlasBinGlyph& glyph : page.glyphs)
+            glyph.page = (uint8_t)i;
+        source.glyphs.insert(source.glyphs.end(), page.glyphs.begin(), page.glyphs.end());
+        source.kerning.insert(source.kerning.end(), page.kerning.begin(), page.kerning.end());
+        source.pages.push_back(page.pages[0]);
+    }
+
+    // keep the first page's entry for duplicated glyphs and kerning pairs
+    std::stable_sort(source.glyphs.begin(), source.glyphs.end(),
+        [](const AtlasBinGlyph& a, const AtlasBinGlyph& b) { return a.codepoint < b.codepoint; });
+    source.glyphs.erase(std::unique(source.glyphs.begin(), source.glyphs.end(),
+        [](const AtlasBinGlyph& a, const AtlasBinGlyph& b) { return a.codepoint == b.codepoint; }), source.glyphs.end());
+    std::stable_sort(source.kerning.begin(), source.kerning.end(),
+        [](const AtlasBinKerning& a, const AtlasBinKerning& b) {
+            return a.left != b.left ? a.left < b.left : a.right < b.right;
+        });
+    source.kerning.erase(std::unique(source.kerning.begin(), source.kerning.end(),
+        [](const AtlasBinKerning& a, const AtlasBinKerning& b) {
+            return a.left == b.left && a.right == b.right;
+        }), source.kerning.end());
+
+    return finalizeAtlasBinSource(source);
+}
+
+// size and hash of the JSON pages an atlas is compiled from, as stored in
+// AtlasBinHeader; false when one of them is missing
+inline bool atlasSourceHash(const std::vector<std::string>& jsonPaths, uint64_t& hash, uint64_t& size) {
+    std::vector<uint64_t> page_hashes;
+    size = 0;
+    for (const std::string& jsonPath : jsonPaths) {
+        MappedFile json;
+        if (!json.open(jsonPath))
+            return false;
+        page_hashes.push_back(hashBytes64(json.data(), json.size()));
+        size += json.size();
+    }
+    if (page_hashes.empty())
+        return false;
+    hash = page_hashes.size() == 1 ? page_hashes[0]
+         : hashBytes64(reinterpret_cast<const unsigned char*>(page_hashes.data()), page_hashes.size() * sizeof(uint64_t));
+    return true;
+}
+
+inline bool writeAtlasBinary(const AtlasBinSource& source, const std::string& atlasPath) {
+    const AtlasBinHeader& header = source.header;
+    std::vector<unsigned char> image(header.file_size, 0);
+    memcpy(image.data(), &header, sizeof(header));
+    if (!source.glyphs.empty())
+        memcpy(image.data() + header.glyph_offset, source.glyphs.data(), source.glyphs.size() * sizeof(AtlasBinGlyph));
+    if (!source.kerning.empty())
+        memcpy(image.data() + header.kerning_offset, source.kerning.data(), source.kerning.size() * sizeof(AtlasBinKerning));
+
+    uint32_t string_offset = 0;
+    for (size_t i = 0; i < source.pages.size(); ++i) {
+        const AtlasBinPageSource& page = source.pages[i];
+        AtlasBinPage record = { string_offset, (uint32_t)page.image.size(), page.width, page.height };
+        memcpy(image.data() + header.page_offset + i * sizeof(AtlasBinPage), &record, sizeof(record));
+        memcpy(image.data() + header.strings_offset + string_offset, page.image.c_str(), page.image.size() + 1);
+        string_offset += (uint32_t)page.image.size() + 1;
+    }
+
+    std::ofstream outputFile(atlasPath, std::ios::binary | std::ios::trunc);
+    if (!outputFile.is_open()) {
+        std::cout << "ERROR::ATLAS::FILE_NOT_SUCCESSFULLY_WRITTEN: " << atlasPath << std::endl;
+        return false;
+    }
+    outputFile.write(reinterpret_cast<const char*>(image.data()), image.size());
+    return outputFile.good();
+}
+
+// compile a msdf-atlas-gen JSON file into a binary *.atlas file
+inline bool compileAtlasBinary(const std::string& jsonPath, const std::string& atlasPath) {
+    AtlasBinSource source;
+    if (!readAtlasJson(jsonPath, source)
+        || !atlasSourceHash({ jsonPath }, source.header.source_hash, source.header.source_size))
+        return false;
+    return writeAtlasBinary(source, atlasPath);
+}
+
+// compile one JSON per texture page into a multi-page *.atlas file; page
+// image paths are stored as derived from the JSON paths (".json" -> ".png")
+inline bool compileAtlasBinary(const std::vector<std::string>& jsonPaths, const std::string& atlasPath) {
+    AtlasBinSource source;
+    if (!readAtlasJsonPages(jsonPaths, source)
+        || !atlasSourceHash(jsonPaths, source.header.source_hash, source.header.source_size))
+        return false;
+    return writeAtlasBinary(source, atlasPath);
+}
+
+// runtime loader
+// ------------------------------------------------------------------------
+
+// read-only mapping of a *.atlas file; the tables are used in place
+class AtlasFile
+{
+public:
+    AtlasFile() {}
+    ~AtlasFile() { close(); }
+
+    AtlasFile(const AtlasFile&) = delete;
+    AtlasFile& operator=(const AtlasFile&) = delete;
+
+    // map the file and validate the header; returns false on a missing,
+    // truncated or incompatible file
+    // ------------------------------------------------------------------------
+    bool open(const std::string& atlasPath)
+    {
+        close();
+        if (!file.open(atlasPath))
+            return false;
+
+        data = file.data();
+        size = file.size();
+        if (size < sizeof(AtlasBinHeader) || !validate()) {
+            std::cout << "ERROR::ATLAS::INVALID_BINARY: " << atlasPath << std::endl;
+            close();
+            return false;
+        }
+        table.build(glyphs(), glyphCount());
+        kerned_right.assign((glyphCount() + 63) / 64, 0);
+        for (uint32_t i = 0; i < kerningCount(); ++i) {
+            uint16_t right = table.lookup(kerning()[i].right);
+            if (right != GLYPH_MISSING)
+                kerned_right[right >> 6] |= 1ull << (right & 63);
+        }
+        return true;
+    }
+    // ------------------------------------------------------------------------
+    void close()
+    {
+        file.close();
+        data = nullptr;
+        size = 0;
+        table.clear();
+        kerned_right.clear();
+    }
+
+    bool isOpen() const { return data != nullptr; }
+    // compiled from JSON of this size and atlasSourceHash()
+    bool matchesSource(uint64_t sourceHash, uint64_t sourceSize) const
+    {
+        return header().source_hash == sourceHash && header().source_size == sourceSize;
+    }
+
+    const AtlasBinHeader& header() const { return *reinterpret_cast<const AtlasBinHeader*>(data); }
+
+    uint32_t glyphCount() const { return header().glyph_count; }
+    const AtlasBinGlyph* glyphs() const { return reinterpret_cast<const AtlasBinGlyph*>(data + header().glyph_offset); }
+
+    uint32_t kerningCount() const { return header().kerning_count; }
+    const AtlasBinKerning* kerning() const { return reinterpret_cast<const AtlasBinKerning*>(data + header().kerning_offset); }
+
+    uint32_t pageCount() const { return header().page_count; }
+    const AtlasBinPage* pages() const { return reinterpret_cast<const AtlasBinPage*>(data + header().page_offset); }
+    std::string pageImage(uint32_t page) const
+    {
+        const AtlasBinPage& record = pages()[page];
+        return std::string(reinterpret_cast<const char*>(data + header().strings_offset + record.image_offset), record.image_length);
+    }
+
+    // O(1) lookup through the codepoint page table, nullptr when not in the atlas
+    // ------------------------------------------------------------------------
+    const AtlasBinGlyph* findGlyph(uint32_t codepoint) const
+    {
+        uint16_t index = table.lookup(codepoint);
+        return index != GLYPH_MISSING ? glyphs() + index : nullptr;
+    }
+    // like findGlyph(), but missing codepoints resolve to the atlas fallback
+    // glyph (U+FFFD, '?' or space); nullptr only for an empty atlas
+    // ------------------------------------------------------------------------
+    const AtlasBinGlyph* glyphOrFallback(uint32_t codepoint) const
+    {
+        uint16_t index = table.lookupOrFallback(codepoint);
+        return index != GLYPH_MISSING ? glyphs() + index : nullptr;
+    }
+
+    const GlyphTable& glyphTable() const { return table; }
+
+    // kerning adjustment in pixels when `right` follows `left`, 0 when the
+    // pair is not kerned; the unkerned case never touches the kerning table
+    // ------------------------------------------------------------------------
+    float kerningAdvance(const AtlasBinGlyph* left, uint32_t right) const
+    {
+        if (left->kerning_count == 0)
+            return 0.0f;
+        const AtlasBinKerning* first = kerning() + left->kerning_first;
+        const AtlasBinKerning* last = first + left->kerning_count;
+        const AtlasBinKerning* it = std::lower_bound(first, last, right,
+            [](const AtlasBinKerning& pair, uint32_t cp) { return pair.right < cp; });
+        return (it != last && it->right == right) ? it->advance : 0.0f;
+    }
+    // as above for a right glyph of this atlas; a right glyph that ends no
+    // pair is rejected from the bitmap without reading the left glyph's run
+    // ------------------------------------------------------------------------
+    float kerningAdvance(const AtlasBinGlyph* left, const AtlasBinGlyph* right) const
+    {
+        size_t index = (size_t)(right - glyphs());
+        if (left->kerning_count == 0 || !(kerned_right[index >> 6] & (1ull << (index & 63))))
+            return 0.0f;
+        return kerningAdvance(left, right->codepoint);
+    }
+    // ------------------------------------------------------------------------
+    float kerningAdvance(uint32_t left, uint32_t right) const
+    {
+        const AtlasBinGlyph* glyph = findGlyph(left);
+        return glyph ? kerningAdvance(glyph, right) : 0.0f;
+    }
+
+private:
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+    GlyphTable table;
+    std::vector<uint64_t> kerned_right;     // bit per glyph index: right side of some pair
+    MappedFile file;
+
+    // ------------------------------------------------------------------------
+    bool validate() const
+    {
+        const AtlasBinHeader& h = header();
+        if (h.magic != ATLAS_BIN_MAGIC || h.version != ATLAS_BIN_VERSION || h.header_size != sizeof(AtlasBinHeader))
+            return false;
+        if (h.y_origin_bottom != 1 || h.glyph_count > GLYPH_MAX_COUNT)
+            return false;
+        if (h.file_size != size)
+            return false;
+        if (h.glyph_offset % ATLAS_BIN_ALIGN != 0 || h.kerning_offset % ATLAS_BIN_ALIGN != 0)
+            return false;
+        if ((uint64_t)h.glyph_offset + (uint64_t)h.glyph_count * sizeof(AtlasBinGlyph) > size)
+            return false;
+        if ((uint64_t)h.kerning_offset + (uint64_t)h.kerning_count * sizeof(AtlasBinKerning) > size)
+            return false;
+        if (h.page_count > ATLAS_BIN_MAX_PAGES || h.page_offset % ATLAS_BIN_ALIGN != 0)
+            return false;
+        if ((uint64_t)h.page_offset + (uint64_t)h.page_count * sizeof(AtlasBinPage) > size)
+            return false;
+        if ((uint64_t)h.strings_offset + h.strings_size > size)
+            return false;
+        const AtlasBinPage* page = reinterpret_cast<const AtlasBinPage*>(data + h.page_offset);
+        for (uint32_t i = 0; i < h.page_count; ++i, ++page) {
+            if ((uint64_t)page->image_offset + page->image_length >= h.strings_size)
+                return false;
+        }
+        const AtlasBinGlyph* glyph = reinterpret_cast<const AtlasBinGlyph*>(data + h.glyph_offset);
+        for (uint32_t i = 0; i < h.glyph_count; ++i, ++glyph) {
+            if ((uint64_t)glyph->kerning_first + glyph->kerning_count > h.kerning_count)
+                return false;
+            if (h.page_count > 0 && glyph->page >= h.page_count)
+                return false;
+        }
+        return true;
+    }
+};
+
+#endif
@@ -0,0 +1,165 @@
+#ifndef MSDF_ATLAS_PAGES_H
+#define MSDF_ATLAS_PAGES_H
+
+// On-demand texture pages of a multi-page atlas. Nothing is decoded or
+// uploaded up front: a page becomes resident the first time laid-out text
+// references it. Texel loading (texel cache / PNG decode) needs no GL and can
+// run on a worker thread; the upload must run on the GL thread.
+
+#include <glad/gl.h>
+
+#include <msdf_atlas_bin.h>
+#include <msdf_texel_blocks.h>
+#include <msdf_texel_cache.h>
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// a run of vertices that samples one atlas page, drawn with that page's texture
+struct PageRange {
+    uint32_t page;
+    uint32_t first;     // first vertex
+    uint32_t count;     // vertex count
+};
+
+// channels of the atlas image for an atlas type
+inline int atlasBinChannels(uint32_t type) {
+    switch (type) {
+    case ATLAS_TYPE_MSDF:  return 3;
+    case ATLAS_TYPE_MTSDF: return 4;
+    default:               return 1;
+    }
+}
+
+class AtlasPages
+{
+public:
+    AtlasPages() {}
+    ~AtlasPages() { release(); }
+
+    AtlasPages(const AtlasPages&) = delete;
+    AtlasPages& operator=(const AtlasPages&) = delete;
+
+    // take the page table of the atlas; no GL calls, nothing is loaded
+    // ------------------------------------------------------------------------
+    void init(const AtlasFile& atlas)
+    {
+        release();
+        pages.clear();
+        for (uint32_t i = 0; i < atlas.pageCount(); ++i) {
+            Page page;
+            page.image = atlas.pageImage(i);
+            page.bytes = (size_t)atlas.pages()[i].width * atlas.pages()[i].height * atlasBinChannels(atlas.header().type);
+            pages.push_back(page);
+        }
+    }
+    // decoded texels of a page: from its block container ("<image>.blocks",
+    // decompressed on all cores) when one is shipped, else from the texel
+    // cache / PNG; no GL calls, so it can run on a worker thread
+    // ------------------------------------------------------------------------
+    TexelImage loadTexels(uint32_t page) const
+    {
+        // the compiler only accepts yOrigin "bottom" atlases (UVs from the bottom
+        // row), so flip to match GL's texture origin
+        const std::string& image = pages[page].image;
+        TexelImage blocks = loadTexelBlocks(texelBlocksPath(image), true, image);
+        if (blocks.pixels != nullptr)
+            return blocks;
+        return ::loadTexels(image, true);
+    }
+    // create the page texture from loaded texels (GL thread)
+    // ------------------------------------------------------------------------
+    bool upload(uint32_t page, const TexelImage& image)
+    {
+        if (image.pixels == nullptr) {
+            std::cout << "ERROR::ATLAS::PAGE_NOT_LOADED: " << pages[page].image << std::endl;
+            pages[page].failed = true;
+            return false;
+        }
+        Page& entry = pages[page];
+        if (entry.texture == 0)
+            glGenTextures(1, &entry.texture);
+        glBindTexture(GL_TEXTURE_2D, entry.texture);
+        // set the texture wrapping parameters
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        // set texture filtering parameters
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        GLenum format = (image.channels == 4) ? GL_RGBA : (image.channels == 3) ? GL_RGB : GL_RED;
+        glTexImage2D(GL_TEXTURE_2D, 0, format, image.width, image.height, 0, format, GL_UNSIGNED_BYTE, image.pixels);
+        entry.bytes = (size_t)image.width * image.height * image.channels;
+        return true;
+    }
+    // make a page resident, loading and uploading it on first use (GL thread);
+    // a page that failed to load stays failed, it is not retried every draw
+    // ------------------------------------------------------------------------
+    bool require(uint32_t page)
+    {
+        if (page >= pages.size() || pages[page].failed)
+            return false;
+        if (pages[page].texture != 0)
+            return true;
+        TexelImage image = loadTexels(page);
+        return upload(page, image);
+    }
+    // ------------------------------------------------------------------------
+    void release()
+    {
+        for (Page& page : pages) {
+            if (page.texture != 0)
+                glDeleteTextures(1, &page.texture);
+            page.texture = 0;
+        }
+    }
+
+    uint32_t pageCount() const { return (uint32_t)pages.size(); }
+    bool isResident(uint32_t page) const { return page < pages.size() && pages[page].texture != 0; }
+    unsigned int texture(uint32_t page) const { return page < pages.size() ? pages[page].texture : 0; }
+
+    // texel memory of all pages, of the resident ones, and what staying lazy saved
+    // ------------------------------------------------------------------------
+    size_t totalBytes() const
+    {
+        size_t total = 0;
+        for (const Page& page : pages)
+            total += page.bytes;
+        return total;
+    }
+    size_t residentBytes() const
+    {
+        size_t resident = 0;
+        for (const Page& page : pages)
+            if (page.texture != 0)
+                resident += page.bytes;
+        return resident;
+    }
+    size_t savedBytes() const { return totalBytes() - residentBytes(); }
+    // ------------------------------------------------------------------------
+    void printResidency() const
+    {
+        uint32_t resident = 0;
+        for (uint32_t i = 0; i < pages.size(); ++i) {
+            if (pages[i].texture != 0)
+                ++resident;
+            std::cout << "  page " << i << " " << (pages[i].texture != 0 ? "resident " : "not loaded ")
+                      << pages[i].image << " (" << pages[i].bytes / 1024 << " KB)" << std::endl;
+        }
+        std::cout << "atlas pages: " << resident << "/" << pages.size() << " resident, "
+                  << residentBytes() / 1024 << " KB used, " << savedBytes() / 1024 << " KB saved" << std::endl;
+    }
+
+private:
+    struct Page {
+        std::string image;
+        size_t bytes = 0;           // texel bytes (estimated from the atlas until uploaded)
+        unsigned int texture = 0;   // 0 while not resident
+        bool failed = false;        // texels could not be loaded; never retried
+    };
+    std::vector<Page> pages;
+};
+
+#endif
@@ -0,0 +1,208 @@
+#ifndef MSDF_BATCH_LAYOUT_H
+#define MSDF_BATCH_LAYOUT_H
+
+// Layout of many labels at once, spread over a pool of worker threads.
+// layoutBatch() first carves one slice of a shared vertex arena per label,
+// sized by a prefix sum over the text lengths (a label never has more glyphs
+// than UTF-8 bytes, see msdf_text_layout.h), then the workers claim labels in
+// chunks and lay each one out into its own slice. No two workers ever write
+// the same memory, so there are no locks on the hot path, and every label is
+// laid out by the same single-threaded code into the same place: the output
+// is bit-identical whatever the thread count or the scheduling.
+//
+// Fonts are immutable once loaded (msdf_font.h), so workers share them
+// freely. The pool runs one batch at a time; keep it on the render thread.
+
+#include <msdf_atlas_pages.h>
+#include <msdf_font.h>
+#include <msdf_text_layout.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+const size_t BATCH_LAYOUT_GRAIN = 16;   // labels claimed by a worker at a time
+
+// threads that sleep between batches; run() hands out [first, last) chunks of
+// a job through an atomic counter and returns when all of them are done. The
+// calling thread works too, so a pool of N threads starts N - 1 workers
+class WorkerPool
+{
+public:
+    // threads = 0: one per hardware thread
+    explicit WorkerPool(unsigned threads = 0)
+    {
+        if (threads == 0)
+            threads = std::thread::hardware_concurrency();
+        for (unsigned i = 1; i < threads; ++i)
+            workers.emplace_back([this]() { workerLoop(); });
+    }
+    ~WorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            quit = true;
+        }
+        wake.notify_all();
+        for (std::thread& worker : workers)
+            worker.join();
+    }
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    unsigned threadCount() const { return (unsigned)workers.size() + 1; }
+
+    // call work(first, last) over [0, count) in chunks of `grain`; blocks
+    // until every chunk has run
+    // ------------------------------------------------------------------------
+    template <typename Work>
+    void run(size_t count, size_t grain, Work& work)
+    {
+        if (grain == 0)
+            grain = 1;
+        if (workers.empty() || count <= grain) {
+            for (size_t first = 0; first < count; first += grain)
+                work(first, std::min(first + grain, count));
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job_call = [](void* context, size_t first, size_t last) { (*static_cast<Work*>(context))(first, last); };
+            job_context = &work;
+            job_count = count;
+            job_grain = grain;
+            next.store(0, std::memory_order_relaxed);
+            busy = (unsigned)workers.size();
+            ++generation;
+        }
+        wake.notify_all();
+        drain();
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this]() { return busy == 0; });
+    }
+
+private:
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake, done;
+    void (*job_call)(void*, size_t, size_t) = nullptr;
+    void* job_context = nullptr;
+    size_t job_count = 0, job_grain = 1;
+    std::atomic<size_t> next{0};
+    unsigned busy = 0;
+    uint64_t generation = 0;
+    bool quit = false;
+
+    void drain()
+    {
+        for (size_t first = next.fetch_add(job_grain); first < job_count; first = next.fetch_add(job_grain))
+            job_call(job_context, first, std::min(first + job_grain, job_count));
+    }
+
+    void workerLoop()
+    {
+        uint64_t seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&]() { return quit || generation != seen; });
+                if (quit)
+                    return;
+                seen = generation;
+            }
+            drain();
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--busy == 0)
+                done.notify_one();
+        }
+    }
+};
+
+// one label to lay out; the text must stay alive until layoutBatch() returns
+struct LabelDesc {
+    const Font* font = nullptr;
+    std::string_view text;
+    float x = 0.0f, y = 0.0f, scale = 1.0f;
+};
+
+// where a label ended up in the batch
+struct LabelSlice {
+    uint32_t first_vertex = 0;          // of the label's slice, in batch vertices
+    uint32_t glyph_count = 0;           // quads written from first_vertex on
+    uint32_t first_range = 0;           // of the label's ranges in LayoutBatch::ranges
+    uint32_t range_count = 0;
+};
+
+// the laid out labels, all in one frame arena allocation. Unused capacity
+// between slices is left unwritten and never referenced by a range
+struct LayoutBatch {
+    float* vertices = nullptr;          // LAYOUT_QUAD_FLOATS per glyph slot
+    size_t capacity = 0;                // glyph slots; upload capacity * LAYOUT_QUAD_FLOATS floats
+    PageRange* ranges = nullptr;        // first relative to vertices
+    LabelSlice* labels = nullptr;       // one per LabelDesc, same order
+    size_t label_count = 0;
+    size_t glyph_count = 0;             // glyphs written over all labels
+
+    bool empty() const { return vertices == nullptr; }
+};
+
+// lay out `count` labels into slices of `arena` on the pool; empty when the
+// arena is full. A label without a font writes no glyphs
+// ------------------------------------------------------------------------
+inline LayoutBatch layoutBatch(const LabelDesc* labels, size_t count, FrameArena& arena, WorkerPool& pool) {
+    LayoutBatch batch;
+    if (count == 0)
+        return batch;
+    LabelSlice* slices = arena.allocate<LabelSlice>(count);
+    if (slices == nullptr)
+        return batch;
+
+    // slices are fixed before any work starts, so where a label goes never
+    // depends on which thread lays it out
+    size_t slots = 0;
+    for (size_t i = 0; i < count; ++i) {
+        slices[i].first_vertex = (uint32_t)(slots * LAYOUT_QUAD_VERTICES);
+        slices[i].first_range = (uint32_t)slots;
+        slots += labels[i].font ? labels[i].text.size() : 0;
+    }
+    float* vertices = arena.allocate<float>(slots * LAYOUT_QUAD_FLOATS);
+    PageRange* ranges = arena.allocate<PageRange>(slots);
+    if (slots && (vertices == nullptr || ranges == nullptr))
+        return batch;
+
+    auto work = [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; ++i) {
+            const LabelDesc& label = labels[i];
+            LabelSlice& slice = slices[i];
+            slice.glyph_count = 0;
+            slice.range_count = 0;
+            if (label.font == nullptr || label.text.empty())
+                continue;
+            size_t size = label.text.size();
+            LayoutTarget target(vertices + (size_t)slice.first_vertex * LAYOUT_VERTEX_FLOATS, size,
+                                ranges + slice.first_range, size);
+            slice.glyph_count = (uint32_t)layoutText(*label.font, label.text, label.x, label.y, label.scale, target);
+            slice.range_count = (uint32_t)target.range_count;
+            for (size_t r = 0; r < target.range_count; ++r)
+                target.ranges[r].first += slice.first_vertex;
+        }
+    };
+    pool.run(count, BATCH_LAYOUT_GRAIN, work);
+
+    batch.vertices = vertices;
+    batch.capacity = slots;
+    batch.ranges = ranges;
+    batch.labels = slices;
+    batch.label_count = count;
+    for (size_t i = 0; i < count; ++i)
+        batch.glyph_count += slices[i].glyph_count;
+    return batch;
+}
+
+#endif
@@ -0,0 +1,1178 @@
+#ifndef MSDF_BENCH_H
+#define MSDF_BENCH_H
+
+// Micro benchmarks for the text pipeline, run with "msdf_demo --bench".
+// They need the atlas only (no GL context) and print one line per case.
+
+#include <msdf_advance_index.h>
+#include <msdf_atlas_bin.h>
+#include <msdf_batch_layout.h>
+#include <msdf_glyph_store.h>
+#include <msdf_glyph_table.h>
+#include <msdf_paragraph.h>
+#include <msdf_texel_blocks.h>
+#include <msdf_text_edit.h>
+#include <msdf_text_layout.h>
+#include <msdf_text_view.h>
+#include <msdf_utf8.h>
+#include <stb_image.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// best-of-N wall time of fn() in seconds
+template <typename Fn>
+inline double benchSeconds(Fn fn, int repeats = 5) {
+    double best = 1e30;
+    for (int i = 0; i < repeats; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        if (elapsed.count() < best)
+            best = elapsed.count();
+    }
+    return best;
+}
+
+// L1 data cache read misses of the calling thread, through perf_event_open on
+// Linux; count() returns -1 where the counter is not available (other
+// platforms, containers without perf access)
+class BenchCacheMisses
+{
+public:
+    BenchCacheMisses()
+    {
+#ifdef __linux__
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.size = sizeof(attr);
+        attr.config = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+    }
+    ~BenchCacheMisses()
+    {
+#ifdef __linux__
+        if (fd >= 0)
+            ::close(fd);
+#endif
+    }
+
+    // run fn() once and return the misses it caused, -1 when unavailable
+    // ------------------------------------------------------------------------
+    template <typename Fn>
+    long long count(Fn fn)
+    {
+#ifdef __linux__
+        if (fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+            fn();
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+            long long misses = 0;
+            if (read(fd, &misses, sizeof(misses)) == sizeof(misses))
+                return misses;
+            return -1;
+        }
+#endif
+        fn();
+        return -1;
+    }
+
+private:
+    int fd = -1;
+};
+
+// keeps the optimizer from dropping benchmark loops
+inline void benchSink(double value) {
+    static volatile double sink = 0.0;
+    sink = sink + value;
+}
+
+// deterministic corpora as codepoint sequences of at least `length` codepoints
+// ------------------------------------------------------------------------
+inline std::vector<uint32_t> benchCorpusAscii(size_t length) {
+    static const char sample[] = "The quick brown fox jumps over the lazy dog. PRESSURE 1013 hPa, SPEED 87 km/h! ";
+    std::vector<uint32_t> text;
+    while (text.size() < length)
+        for (const char* c = sample; *c; ++c)
+            text.push_back((unsigned char)*c);
+    return text;
+}
+
+inline std::vector<uint32_t> benchCorpusLatin(size_t length) {
+    static const char32_t sample[] = U"Größenänderung der Maße, café naïve Ærøskøbing, señor François. ";
+    std::vector<uint32_t> text;
+    while (text.size() < length)
+        for (const char32_t* c = sample; *c; ++c)
+            text.push_back((uint32_t)*c);
+    return text;
+}
+
+// CJK ideographs drawn from [first, first + range) mixed with ASCII punctuation
+inline std::vector<uint32_t> benchCorpusCjk(size_t length, uint32_t first = 0x4E00, uint32_t range = 3000) {
+    std::vector<uint32_t> text;
+    uint32_t seed = 12345;
+    while (text.size() < length) {
+        seed = seed * 1664525u + 1013904223u;
+        text.push_back((seed >> 8) % 16 == 0 ? (uint32_t)',' : first + (seed >> 8) % range);
+    }
+    return text;
+}
+
+// the atlas glyphs plus `extra` synthetic CJK glyphs from U+4E00, so lookups
+// can be measured against a CJK sized font with the ASCII test atlas
+inline std::vector<AtlasBinGlyph> benchGlyphSet(const AtlasFile& atlas, uint32_t extra = 3000) {
+    std::vector<AtlasBinGlyph> glyphs(atlas.glyphs(), atlas.glyphs() + atlas.glyphCount());
+    AtlasBinGlyph ideograph = atlas.glyphCount() ? atlas.glyphs()[atlas.glyphCount() - 1] : AtlasBinGlyph();
+    for (uint32_t i = 0; i < extra; ++i) {
+        ideograph.codepoint = 0x4E00 + i;
+        glyphs.push_back(ideograph);
+    }
+    return glyphs;
+}
+
+inline void benchReport(const std::string& name, double seconds, double items, const char* unit) {
+    std::cout << "  " << std::left << std::setw(44) << name << std::right << std::setw(10) << std::fixed
+              << std::setprecision(2) << (items / seconds) / 1e6 << " M" << unit << "/s" << std::endl;
+}
+
+// std::map<codepoint, glyph> (the former glyph store) against GlyphTable
+// ------------------------------------------------------------------------
+inline void benchGlyphLookup(const AtlasFile& atlas) {
+    std::vector<AtlasBinGlyph> glyphs = benchGlyphSet(atlas);
+
+    std::map<uint32_t, AtlasBinGlyph> glyph_map;
+    for (const AtlasBinGlyph& glyph : glyphs)
+        glyph_map[glyph.codepoint] = glyph;
+
+    GlyphTable table;
+    table.build(glyphs.data(), (uint32_t)glyphs.size());
+
+    std::cout << "glyph lookup (" << glyphs.size() << " glyphs, table " << table.memoryBytes() / 1024 << " KB in "
+              << table.pageCount() << " pages)" << std::endl;
+
+    const size_t length = 1 << 20;
+    struct Corpus { const char* name; std::vector<uint32_t> text; };
+    Corpus corpora[] = {
+        { "ascii", benchCorpusAscii(length) },
+        { "latin", benchCorpusLatin(length) },
+        { "cjk", benchCorpusCjk(length) },
+    };
+
+    for (const Corpus& corpus : corpora) {
+        const std::vector<uint32_t>& text = corpus.text;
+
+        double map_time = benchSeconds([&]() {
+            float advance = 0.0f;
+            for (uint32_t codepoint : text) {
+                auto it = glyph_map.find(codepoint);
+                if (it != glyph_map.end())
+                    advance += it->second.advance;
+            }
+            benchSink(advance);
+        });
+        double table_time = benchSeconds([&]() {
+            float advance = 0.0f;
+            for (uint32_t codepoint : text) {
+                uint16_t index = table.lookup(codepoint);
+                if (index != GLYPH_MISSING)
+                    advance += glyphs[index].advance;
+            }
+            benchSink(advance);
+        });
+
+        benchReport(std::string(corpus.name) + " std::map", map_time, (double)text.size(), "lookups");
+        benchReport(std::string(corpus.name) + " GlyphTable", table_time, (double)text.size(), "lookups");
+    }
+}
+
+// the former dense kerning_table[256][256], a binary search over all pairs,
+// the per-glyph kerning runs of the atlas and the GlyphStore runs layout
+// uses (both behind their has-run / right-side rejects), walking
+// consecutive pairs
+// ------------------------------------------------------------------------
+inline void benchKerning(const AtlasFile& atlas) {
+    GlyphStore store;
+    store.build(atlas);
+
+    std::vector<float> dense(256 * 256, 0.0f);
+    for (uint32_t i = 0; i < atlas.kerningCount(); ++i) {
+        const AtlasBinKerning& pair = atlas.kerning()[i];
+        if (pair.left < 256 && pair.right < 256)
+            dense[pair.left * 256 + pair.right] = pair.advance;
+    }
+
+    std::cout << "kerning (" << atlas.kerningCount() << " pairs, dense table " << dense.size() * sizeof(float) / 1024
+              << " KB, pair table " << atlas.kerningCount() * sizeof(AtlasBinKerning) / 1024.0 << " KB)" << std::endl;
+
+    const size_t length = 1 << 20;
+    struct Corpus { const char* name; std::vector<uint32_t> text; };
+    Corpus corpora[] = {
+        { "ascii", benchCorpusAscii(length) },
+        { "latin", benchCorpusLatin(length) },
+    };
+
+    BenchCacheMisses misses;
+    for (const Corpus& corpus : corpora) {
+        std::vector<const AtlasBinGlyph*> glyphs;
+        std::vector<uint16_t> indices;
+        for (uint32_t codepoint : corpus.text) {
+            glyphs.push_back(atlas.glyphOrFallback(codepoint));
+            indices.push_back((uint16_t)(glyphs.back() - atlas.glyphs()));
+        }
+        size_t pairs = glyphs.size() - 1;
+
+        auto dense_loop = [&]() {
+            float advance = 0.0f;
+            for (size_t i = 1; i < glyphs.size(); ++i)
+                advance += dense[(glyphs[i - 1]->codepoint & 0xFF) * 256 + (glyphs[i]->codepoint & 0xFF)];
+            benchSink(advance);
+        };
+        auto search_loop = [&]() {
+            const AtlasBinKerning* first = atlas.kerning();
+            const AtlasBinKerning* last = first + atlas.kerningCount();
+            float advance = 0.0f;
+            for (size_t i = 1; i < glyphs.size(); ++i) {
+                uint32_t left = glyphs[i - 1]->codepoint;
+                uint32_t right = glyphs[i]->codepoint;
+                const AtlasBinKerning* it = std::lower_bound(first, last, left, AtlasBinKerningLeft());
+                for (; it != last && it->left == left && it->right <= right; ++it)
+                    if (it->right == right)
+                        advance += it->advance;
+            }
+            benchSink(advance);
+        };
+        auto run_loop = [&]() {
+            float advance = 0.0f;
+            for (size_t i = 1; i < glyphs.size(); ++i)
+                advance += atlas.kerningAdvance(glyphs[i - 1], glyphs[i]);
+            benchSink(advance);
+        };
+        auto store_loop = [&]() {
+            float advance = 0.0f;
+            for (size_t i = 1; i < indices.size(); ++i)
+                advance += store.kerning(indices[i - 1], indices[i]);
+            benchSink(advance);
+        };
+
+        struct Variant { const char* name; std::function<void()> loop; };
+        Variant variants[] = {
+            { " dense 256x256", dense_loop },
+            { " sorted pairs", search_loop },
+            { " per-glyph runs", run_loop },
+            { " GlyphStore runs", store_loop },
+        };
+        for (const Variant& variant : variants) {
+            double seconds = benchSeconds(variant.loop);
+            long long miss_count = misses.count(variant.loop);
+            benchReport(std::string(corpus.name) + variant.name, seconds, (double)pairs, "pairs");
+            if (miss_count >= 0)
+                std::cout << "    L1D read misses per 1k pairs: " << std::setprecision(2) << miss_count * 1000.0 / pairs << std::endl;
+            else
+                std::cout << "    L1D read misses: n/a" << std::endl;
+        }
+    }
+}
+
+// the layout loop over long strings (lookup, kerning, quad corners and UVs
+// into a preallocated buffer) with the 48 byte atlas records against the
+// hot/cold GlyphStore arrays, for a small and a full size CJK glyph set. The
+// store loop runs once more kerning from the former dense 256x256 table, the
+// comparison benchKerning cannot make outside the layout loop
+// ------------------------------------------------------------------------
+inline void benchGlyphLayout(const AtlasFile& atlas, uint32_t cjkGlyphs) {
+    std::vector<AtlasBinGlyph> glyphs = benchGlyphSet(atlas, cjkGlyphs);
+    GlyphTable table;
+    table.build(glyphs.data(), (uint32_t)glyphs.size());
+    GlyphStore store;
+    store.build(glyphs.data(), (uint32_t)glyphs.size(), atlas.kerning(), atlas.kerningCount());
+
+    std::cout << "glyph layout (" << glyphs.size() << " glyphs, atlas records "
+              << glyphs.size() * sizeof(AtlasBinGlyph) / 1024 << " KB, hot records "
+              << glyphs.size() * sizeof(GlyphHot) / 1024 << " KB, glyph store "
+              << store.memoryBytes() / 1024 << " KB)" << std::endl;
+
+    const size_t length = 1 << 20;
+    struct Corpus { const char* name; std::vector<uint32_t> text; };
+    std::vector<Corpus> corpora;
+    if (cjkGlyphs <= 3000) {
+        corpora.push_back({ "ascii", benchCorpusAscii(length) });
+        corpora.push_back({ "latin", benchCorpusLatin(length) });
+    }
+    corpora.push_back({ "cjk", benchCorpusCjk(length, 0x4E00, cjkGlyphs) });
+
+    std::vector<float> dense(256 * 256, 0.0f);
+    for (uint32_t i = 0; i < atlas.kerningCount(); ++i) {
+        const AtlasBinKerning& pair = atlas.kerning()[i];
+        if (pair.left < 256 && pair.right < 256)
+            dense[pair.left * 256 + pair.right] = pair.advance;
+    }
+
+    const float scale = 0.25f;
+    std::vector<float> quads(length * 8 + 64);
+    for (const Corpus& corpus : corpora) {
+        const std::vector<uint32_t>& text = corpus.text;
+
+        double records_time = benchSeconds([&]() {
+            const AtlasBinKerning* kerning = atlas.kerning();
+            float* out = quads.data();
+            float x = 0.0f;
+            const AtlasBinGlyph* prev = nullptr;
+            for (uint32_t codepoint : text) {
+                const AtlasBinGlyph* glyph = &glyphs[table.lookupOrFallback(codepoint)];
+                if (glyph->flags & ATLAS_GLYPH_VISIBLE) {
+                    out[0] = x + glyph->pl * scale; out[1] = glyph->pb * scale;
+                    out[2] = x + glyph->pr * scale; out[3] = glyph->pt * scale;
+                    out[4] = glyph->u0; out[5] = glyph->v0; out[6] = glyph->u1; out[7] = glyph->v1;
+                    out += 8;
+                }
+                float pair = 0.0f;
+                if (prev && prev->kerning_count) {
+                    const AtlasBinKerning* first = kerning + prev->kerning_first;
+                    const AtlasBinKerning* last = first + prev->kerning_count;
+                    const AtlasBinKerning* it = std::lower_bound(first, last, glyph->codepoint,
+                        [](const AtlasBinKerning& k, uint32_t cp) { return k.right < cp; });
+                    if (it != last && it->right == glyph->codepoint)
+                        pair = it->advance;
+                }
+                x += (glyph->advance + pair) * scale;
+                prev = glyph;
+            }
+            benchSink(x + out[-1]);
+        });
+        auto store_loop = [&](auto kerning) {
+            const GlyphHot* hot = store.hot();
+            const GlyphCold* cold = store.cold();
+            const float plane_scale = store.planeUnit() * scale;
+            float* out = quads.data();
+            float x = 0.0f;
+            uint16_t prev = GLYPH_MISSING;
+            for (uint32_t codepoint : text) {
+                uint16_t glyph = table.lookupOrFallback(codepoint);
+                const GlyphHot& metrics = hot[glyph];
+                if (GlyphStore::visible(metrics)) {
+                    const GlyphCold& uv = cold[glyph];
+                    GlyphStore::planeBounds(metrics, x, 0.0f, plane_scale, out);
+                    out[4] = uv.u0; out[5] = uv.v0; out[6] = uv.u1; out[7] = uv.v1;
+                    out += 8;
+                }
+                float pair = prev != GLYPH_MISSING ? kerning(prev, glyph) : 0.0f;
+                x += (metrics.advance + pair) * scale;
+                prev = glyph;
+            }
+            benchSink(x + out[-1]);
+        };
+        double store_time = benchSeconds([&]() {
+            store_loop([&](uint16_t left, uint16_t right) { return store.kerning(left, right); });
+        });
+        double dense_time = benchSeconds([&]() {
+            const uint32_t* codepoints = store.codepoints();
+            store_loop([&](uint16_t left, uint16_t right) {
+                uint32_t l = codepoints[left], r = codepoints[right];
+                return (l | r) < 256 ? dense[l * 256 + r] : 0.0f;
+            });
+        });
+
+        benchReport(std::string(corpus.name) + " atlas records (AoS)", records_time, (double)text.size(), "glyphs");
+        benchReport(std::string(corpus.name) + " hot/cold GlyphStore", store_time, (double)text.size(), "glyphs");
+        benchReport(std::string(corpus.name) + " hot/cold, dense kerning", dense_time, (double)text.size(), "glyphs");
+    }
+}
+
+// decode of the first atlas page: the serial PNG inflate against the block
+// container on 1..N threads, and a partial decode of one band
+// ------------------------------------------------------------------------
+inline void benchTexelBlocks(const AtlasFile& atlas) {
+    if (atlas.pageCount() == 0)
+        return;
+    std::string path = atlas.pageImage(0);
+    MappedFile png;
+    if (!png.open(path)) {
+        std::cout << "texel blocks: " << path << " not found" << std::endl;
+        return;
+    }
+    // the shipped "<image>.blocks" when it is current, else one packed here
+    TexelBlockFile blocks;
+    MappedFile shipped;
+    std::vector<unsigned char> container;
+    uint64_t hash = hashBytes64(png.data(), png.size());
+    bool from_file = shipped.open(texelBlocksPath(path)) && blocks.view(shipped.data(), shipped.size()) &&
+                     blocks.header().source_hash == hash && blocks.header().source_size == png.size() &&
+                     blocks.header().flipped == 1;
+    if (from_file) {
+        container.assign(shipped.data(), shipped.data() + shipped.size());
+    } else {
+        int width, height, channels;
+        stbi_set_flip_vertically_on_load_thread(1);
+        unsigned char* pixels = stbi_load_from_memory(png.data(), (int)png.size(), &width, &height, &channels, 0);
+        if (pixels == nullptr)
+            return;
+        container = packTexelBlocks(pixels, width, height, channels, true, hash, png.size());
+        stbi_image_free(pixels);
+    }
+    blocks.view(container.data(), container.size());
+    const uint32_t height = blocks.header().height;
+    const double raw = (double)blocks.imageBytes();
+    std::cout << "texel blocks (" << path << ", " << blocks.header().width << "x" << height << "x"
+              << blocks.header().channels << ", raw " << (size_t)raw / 1024 << " KB, png " << png.size() / 1024
+              << " KB, blocks " << container.size() / 1024 << " KB in " << blocks.header().block_count << " bands"
+              << (from_file ? ", shipped" : "") << ")" << std::endl;
+
+    double png_time = benchSeconds([&]() {
+        int w, h, c;
+        unsigned char* decoded = stbi_load_from_memory(png.data(), (int)png.size(), &w, &h, &c, 0);
+        benchSink(decoded ? decoded[0] : 0);
+        stbi_image_free(decoded);
+    });
+    benchReport("png decode (stb_image, 1 thread)", png_time, raw, "B");
+    std::cout << "    " << std::setprecision(3) << png_time * 1000.0 << " ms per page" << std::endl;
+
+    std::vector<unsigned char> upload(blocks.imageBytes());
+    unsigned cores = texelBlocksThreads(0);
+    std::vector<unsigned> thread_counts;
+    for (unsigned threads = 1; threads < cores; threads *= 2)
+        thread_counts.push_back(threads);
+    thread_counts.push_back(cores);
+    for (unsigned threads : thread_counts) {
+        TexelDecodeStats stats;
+        double seconds = benchSeconds([&]() { blocks.decodeRows(0, height, upload.data(), threads, &stats); });
+        benchReport("blocks decode, " + std::to_string(threads) + " threads", seconds, raw, "B");
+        std::cout << "    " << std::setprecision(3) << seconds * 1000.0 << " ms per page, per core "
+                  << stats.megabytesPerSecondPerCore() << " MB/s" << std::endl;
+    }
+    TexelDecodeStats band;
+    double band_time = benchSeconds([&]() { blocks.decodeRows(height / 2, 1, upload.data(), 1, &band); });
+    benchReport("blocks decode, one band of rows", band_time, (double)band.bytes, "B");
+}
+
+// per-label layout of short HMI strings: a fresh std::vector grown glyph by
+// glyph and returned by value (the former generateVertexData) against
+// layoutText() into the frame arena
+// ------------------------------------------------------------------------
+inline void benchLayoutTarget(const Font& font) {
+    std::vector<std::string> labels;
+    std::vector<uint32_t> corpus = benchCorpusAscii(1 << 16);
+    for (size_t i = 0; i + 24 <= corpus.size(); i += 24)
+        labels.push_back(std::string(corpus.begin() + i, corpus.begin() + i + 8 + i % 16));
+    size_t characters = 0;
+    for (const std::string& label : labels)
+        characters += label.size();
+
+    std::cout << "label layout (" << labels.size() << " labels, " << characters << " characters)" << std::endl;
+
+    const GlyphStore& glyphs = font.glyphs();
+    auto vectorLayout = [&](std::string text, float x, float y, float scale) {
+        std::vector<float> vertices;
+        const float plane_scale = glyphs.planeUnit() * scale;
+        uint16_t prev_glyph = GLYPH_MISSING;
+        for (char c : text) {
+            uint16_t glyph = font.glyphIndex((unsigned char)c);
+            const GlyphHot& metrics = glyphs.hot()[glyph];
+            if (GlyphStore::visible(metrics)) {
+                const GlyphCold& uv = glyphs.cold()[glyph];
+                float q[4];
+                GlyphStore::planeBounds(metrics, x, y, plane_scale, q);
+                vertices.insert(vertices.end(), {
+                    q[2], q[3], 0.0f,  1.0f, 0.0f, 0.0f,   uv.u1, uv.v1,
+                    q[2], q[1], 0.0f,  0.0f, 1.0f, 0.0f,   uv.u1, uv.v0,
+                    q[0], q[3], 0.0f,  1.0f, 1.0f, 0.0f,   uv.u0, uv.v1,
+                    q[2], q[1], 0.0f,  0.0f, 1.0f, 0.0f,   uv.u1, uv.v0,
+                    q[0], q[1], 0.0f,  0.0f, 0.0f, 1.0f,   uv.u0, uv.v0,
+                    q[0], q[3], 0.0f,  1.0f, 1.0f, 0.0f,   uv.u0, uv.v1
+                });
+            }
+            float kerning = prev_glyph != GLYPH_MISSING ? glyphs.kerning(prev_glyph, glyph) : 0.0f;
+            x += (metrics.advance + kerning) * scale;
+            prev_glyph = glyph;
+        }
+        return vertices;
+    };
+
+    double vector_time = benchSeconds([&]() {
+        double sum = 0.0;
+        for (const std::string& label : labels) {
+            std::vector<float> vertices = vectorLayout(label, 10.0f, 20.0f, 0.5f);
+            sum += vertices.size();
+        }
+        benchSink(sum);
+    });
+
+    FrameArena arena(characters * LAYOUT_QUAD_FLOATS * sizeof(float) + labels.size() * 64);
+    double arena_time = benchSeconds([&]() {
+        arena.reset();
+        double sum = 0.0;
+        for (const std::string& label : labels) {
+            LayoutTarget target = LayoutTarget::fromArena(arena, label.size(), 1);
+            sum += layoutText(font, label, 10.0f, 20.0f, 0.5f, target);
+        }
+        benchSink(sum);
+    });
+
+    benchReport("std::vector per label", vector_time, (double)characters, "glyphs");
+    benchReport("layoutText into frame arena", arena_time, (double)characters, "glyphs");
+}
+
+// paragraph-sized layout (2000 characters into one reused buffer, as a log or
+// console view does per paragraph) with the scalar and the SIMD quad emitter
+// ------------------------------------------------------------------------
+inline void benchQuadEmit(const Font& font) {
+#if defined(MSDF_LAYOUT_AVX)
+    const char* simd = "AVX";
+#elif defined(MSDF_GLYPH_STORE_SSE2)
+    const char* simd = "SSE2";
+#else
+    const char* simd = "none, scalar";
+#endif
+    const size_t paragraph = 2000;
+    const size_t paragraphs = 256;
+    std::cout << "quad emission (" << paragraphs << " paragraphs of " << paragraph << " characters, SIMD: " << simd << ")" << std::endl;
+
+    struct Corpus { const char* name; std::vector<uint32_t> text; };
+    Corpus corpora[] = {
+        { "ascii", benchCorpusAscii(paragraph * paragraphs) },
+        { "latin", benchCorpusLatin(paragraph * paragraphs) },
+    };
+    std::vector<float> vertices(paragraph * LAYOUT_QUAD_FLOATS);
+    for (const Corpus& corpus : corpora) {
+        auto run = [&](auto layout) {
+            double glyphs = 0.0;
+            for (size_t p = 0; p < paragraphs; ++p) {
+                LayoutTarget target(vertices.data(), paragraph);
+                const uint32_t* first = corpus.text.data() + p * paragraph;
+                glyphs += layout(first, first + paragraph, target);
+            }
+            benchSink(glyphs + vertices[7]);
+        };
+        double scalar_time = benchSeconds([&]() {
+            run([&](const uint32_t* first, const uint32_t* last, LayoutTarget& target) {
+                return layoutCodepointRun<uint32_t, false>(font, first, last, 10.0f, 20.0f, 0.25f, target);
+            });
+        });
+        double simd_time = benchSeconds([&]() {
+            run([&](const uint32_t* first, const uint32_t* last, LayoutTarget& target) {
+                return layoutCodepointRun<uint32_t, true>(font, first, last, 10.0f, 20.0f, 0.25f, target);
+            });
+        });
+        double characters = (double)(paragraph * paragraphs);
+        benchReport(std::string(corpus.name) + " scalar quads", scalar_time, characters, "glyphs");
+        benchReport(std::string(corpus.name) + " SIMD quads", simd_time, characters, "glyphs");
+    }
+}
+
+// UTF-8 text of at least `bytes` bytes repeating a codepoint corpus
+inline std::string benchCorpusUtf8(const std::vector<uint32_t>& codepoints, size_t bytes) {
+    std::string text;
+    while (text.size() < bytes)
+        for (uint32_t codepoint : codepoints)
+            utf8Append(text, codepoint);
+    return text;
+}
+
+// UTF-8 decoding one sequence at a time against the ASCII block fast path,
+// then layoutText() end to end on the same bytes
+// ------------------------------------------------------------------------
+inline void benchUtf8Decode(const Font& font) {
+#if defined(MSDF_UTF8_AVX2)
+    const char* simd = "AVX2, 32 bytes";
+#elif defined(MSDF_UTF8_SSE2)
+    const char* simd = "SSE2, 16 bytes";
+#else
+    const char* simd = "none, scalar";
+#endif
+    const size_t bytes = 1 << 20;
+    std::cout << "UTF-8 decoding (" << (bytes >> 20) << " MB per corpus, ASCII fast path: " << simd << ")" << std::endl;
+
+    static const char32_t german[] = U"Falsches Üben von Xylophonmusik quält jeden größeren Zwerg. ";
+    static const char32_t cyrillic[] = U"Съешь же ещё этих мягких французских булок, да выпей чаю. ";
+    struct Corpus { const char* name; std::string text; };
+    Corpus corpora[] = {
+        { "english", benchCorpusUtf8(benchCorpusAscii(64), bytes) },
+        { "german", benchCorpusUtf8(std::vector<uint32_t>(german, german + sizeof(german) / sizeof(german[0]) - 1), bytes) },
+        { "cyrillic", benchCorpusUtf8(std::vector<uint32_t>(cyrillic, cyrillic + sizeof(cyrillic) / sizeof(cyrillic[0]) - 1), bytes) },
+        { "cjk", benchCorpusUtf8(benchCorpusCjk(4096), bytes) },
+    };
+
+    std::vector<uint32_t> codepoints(bytes + 4096);
+    const size_t line = 2000;   // layoutText() per paragraph-sized slice
+    std::vector<float> vertices(line * LAYOUT_QUAD_FLOATS);
+    for (const Corpus& corpus : corpora) {
+        const unsigned char* text = reinterpret_cast<const unsigned char*>(corpus.text.data());
+        const unsigned char* text_end = text + corpus.text.size();
+        size_t decoded = 0;
+        auto decode = [&](auto fastPath) {
+            const unsigned char* in = text;
+            decoded = utf8Decode<decltype(fastPath)::value>(in, text_end, codepoints.data(), codepoints.size());
+            benchSink((double)codepoints[decoded / 2]);
+        };
+        double scalar_time = benchSeconds([&]() { decode(std::false_type()); });
+        double simd_time = benchSeconds([&]() { decode(std::true_type()); });
+        double layout_time = benchSeconds([&]() {
+            double glyphs = 0.0;
+            for (size_t offset = 0; offset < corpus.text.size(); offset += line) {
+                // slices may split a sequence; that only costs a U+FFFD at each cut
+                std::string_view slice(corpus.text.data() + offset, std::min(line, corpus.text.size() - offset));
+                LayoutTarget target(vertices.data(), line);
+                glyphs += layoutText(font, slice, 10.0f, 20.0f, 0.25f, target);
+            }
+            benchSink(glyphs);
+        });
+        double size = (double)corpus.text.size();
+        std::cout << "  " << corpus.name << ": " << decoded << " codepoints, "
+                  << std::setprecision(2) << size / decoded << " bytes each" << std::endl;
+        benchReport(std::string(corpus.name) + " scalar decode", scalar_time, size, "B");
+        benchReport(std::string(corpus.name) + " fast path decode", simd_time, size, "B");
+        benchReport(std::string(corpus.name) + " layoutText (decode + layout)", layout_time, size, "B");
+    }
+}
+
+// a 200 paragraph panel: full layout, one edited paragraph and a resize,
+// against laying out every paragraph again as single lines
+// ------------------------------------------------------------------------
+inline void benchParagraphLayout(const Font& font) {
+    const size_t count = 200;
+    std::vector<uint32_t> words = benchCorpusAscii(count * 160);
+    std::string text;
+    for (size_t p = 0; p < count; ++p) {
+        for (size_t c = p * 160 + (p % 7) * 5; c < (p + 1) * 160; ++c)
+            text += (char)words[c];
+        if (p + 1 < count)
+            text += '\n';
+    }
+    std::cout << "paragraph layout (" << count << " paragraphs, " << text.size() << " bytes)" << std::endl;
+
+    const float scale = 0.25f;
+    size_t lines = 0;
+    double full_time = benchSeconds([&]() {
+        ParagraphLayout layout(font, scale, 600.0f, PARAGRAPH_ALIGN_CENTER);
+        layout.setText(text);
+        layout.update();
+        lines = layout.lineCount();
+        benchSink(layout.height());
+    });
+
+    std::vector<float> vertices(text.size() * LAYOUT_QUAD_FLOATS);
+    double single_time = benchSeconds([&]() {
+        double written = 0.0;
+        size_t begin = 0;
+        while (begin < text.size()) {
+            size_t end = std::min(text.find('\n', begin), text.size());
+            LayoutTarget target(vertices.data(), end - begin);
+            written += layoutText(font, std::string_view(text).substr(begin, end - begin), 0.0f, 0.0f, scale, target);
+            begin = end + 1;
+        }
+        benchSink(written);
+    });
+
+    ParagraphLayout layout(font, scale, 600.0f, PARAGRAPH_ALIGN_CENTER);
+    layout.setText(text);
+    layout.update();
+    std::string edited = text;
+    size_t edits = 0;
+    double edit_time = benchSeconds([&]() {
+        edited[text.size() / 2] = (edits++ & 1) ? 'x' : 'y';
+        layout.setText(edited);
+        benchSink((double)layout.update());
+    });
+    size_t resizes = 0;
+    double resize_time = benchSeconds([&]() {
+        layout.setWidth((resizes++ & 1) ? 600.0f : 640.0f);
+        benchSink((double)layout.update());
+    });
+
+    double bytes = (double)text.size();
+    benchReport("layoutText, single lines", single_time, bytes, "B");
+    benchReport("ParagraphLayout, wrapped + centered", full_time, bytes, "B");
+    std::cout << "  " << lines << " lines; one edited paragraph "
+              << std::setprecision(1) << edit_time * 1e6 << " us, resize (full reflow) " << resize_time * 1e6 << " us" << std::endl;
+}
+
+// typing into a 64 KB notes buffer: EditableText against laying out the
+// whole text again per keystroke
+// ------------------------------------------------------------------------
+inline void benchTextEdit(const Font& font) {
+    std::vector<uint32_t> words = benchCorpusAscii(64 * 1024);
+    std::string text;
+    for (size_t i = 0; i < words.size(); ++i)
+        text += (i % 72 == 71) ? '\n' : (char)words[i];
+    const size_t keystrokes = 200;
+    const float scale = 0.25f;
+    std::cout << "text editing (" << text.size() / 1024 << " KB, " << keystrokes << " keystrokes mid-text)" << std::endl;
+
+    std::vector<float> vertices(text.size() * LAYOUT_QUAD_FLOATS * 2);
+    double full_time = benchSeconds([&]() {
+        std::string edited = text;
+        double glyphs = 0.0;
+        for (size_t k = 0; k < keystrokes; ++k) {
+            edited.insert(text.size() / 2 + k, 1, (k % 9 == 8) ? ' ' : 'e');
+            LayoutTarget target(vertices.data(), edited.size());
+            glyphs += layoutText(font, edited, 0.0f, 0.0f, scale, target);
+        }
+        benchSink(glyphs);
+    }, 3);
+
+    // one editor across the repeats: each repeat types further into the same line
+    EditableText editor(font, scale, text);
+    size_t relaid = 0, dirty_floats = 0, typed = 0;
+    double edit_time = benchSeconds([&]() {
+        size_t before = editor.relaidLines();
+        dirty_floats = 0;
+        for (size_t k = 0; k < keystrokes; ++k, ++typed) {
+            editor.clearDirty();
+            editor.insert(text.size() / 2 + typed, (typed % 9 == 8) ? " " : "e");
+            size_t first, end;
+            if (editor.dirty(first, end))
+                dirty_floats += end - first;
+        }
+        relaid = editor.relaidLines() - before;
+        benchSink((double)editor.vertices().size());
+    }, 3);
+
+    std::cout << std::fixed << std::setprecision(1)
+              << "  full relayout per keystroke                 " << full_time / keystrokes * 1e6 << " us" << std::endl
+              << "  EditableText line relayout per keystroke    " << edit_time / keystrokes * 1e6 << " us" << std::endl
+              << "  " << relaid << " lines laid out, " << dirty_floats * sizeof(float) / keystrokes / 1024
+              << " KB dirty per keystroke" << std::endl;
+}
+
+// measureText() against layoutText() on the same paragraphs
+// ------------------------------------------------------------------------
+inline void benchMeasure(const Font& font) {
+    const size_t paragraph = 2000;
+    const size_t paragraphs = 256;
+    std::cout << "measuring (" << paragraphs << " paragraphs of " << paragraph << " characters)" << std::endl;
+
+    struct Corpus { const char* name; std::string text; };
+    Corpus corpora[] = {
+        { "ascii", benchCorpusUtf8(benchCorpusAscii(paragraph), paragraph * paragraphs) },
+        { "latin", benchCorpusUtf8(benchCorpusLatin(paragraph), paragraph * paragraphs) },
+    };
+    std::vector<float> vertices(paragraph * LAYOUT_QUAD_FLOATS);
+    for (const Corpus& corpus : corpora) {
+        std::string_view text(corpus.text);
+        double layout_time = benchSeconds([&]() {
+            double glyphs = 0.0;
+            for (size_t p = 0; p < paragraphs; ++p) {
+                LayoutTarget target(vertices.data(), paragraph);
+                glyphs += layoutText(font, text.substr(p * paragraph, paragraph), 0.0f, 0.0f, 0.25f, target);
+            }
+            benchSink(glyphs + vertices[7]);
+        });
+        double measure_time = benchSeconds([&]() {
+            double width = 0.0;
+            for (size_t p = 0; p < paragraphs; ++p)
+                width += measureText(font, text.substr(p * paragraph, paragraph), 0.25f).width;
+            benchSink(width);
+        });
+        double bytes = (double)(paragraph * paragraphs);
+        benchReport(std::string(corpus.name) + " layoutText", layout_time, bytes, "B");
+        benchReport(std::string(corpus.name) + " measureText", measure_time, bytes, "B");
+        std::cout << "  " << corpus.name << " measure speedup " << std::setprecision(1) << layout_time / measure_time << "x" << std::endl;
+    }
+}
+
+// "..." truncation and hit testing on a 10k character line: a full layout
+// plus a linear scan (the former way) against ellipsizeText(), which stops
+// at the overflow, and against binary searches on an AdvanceIndex
+// ------------------------------------------------------------------------
+inline void benchAdvanceIndex(const Font& font) {
+    const size_t length = 10000;
+    const float scale = 0.2f;
+    const float max_width = 400.0f;
+    const size_t queries = 1000;
+    std::string text = benchCorpusUtf8(benchCorpusLatin(length), length * 2);
+    text.resize(length);
+    while (!text.empty() && ((unsigned char)text.back() & 0xC0) == 0x80)
+        text.pop_back();
+    if (!text.empty() && (unsigned char)text.back() >= 0xC0)
+        text.pop_back();
+    std::cout << "advance index (" << text.size() << " byte line cut to " << max_width << " px, "
+              << queries << " hit tests)" << std::endl;
+
+    std::vector<float> vertices(text.size() * LAYOUT_QUAD_FLOATS);
+    std::vector<float> pens(text.size() + 1);
+    const float mark_width = ellipsisWidth(font, scale);
+    size_t kept = 0;
+    double layout_time = benchSeconds([&]() {
+        LayoutTarget target(vertices.data(), text.size());
+        target.pens = pens.data();
+        target.pen_capacity = pens.size();
+        layoutText(font, text, 0.0f, 0.0f, scale, target);
+        size_t fit = 0;
+        while (fit + 1 < target.pen_count && pens[fit + 1] <= max_width - mark_width)
+            ++fit;
+        kept = fit;
+        benchSink((double)fit);
+    });
+    Ellipsis cut;
+    double scan_time = benchSeconds([&]() {
+        cut = ellipsizeText(font, text, scale, max_width);
+        benchSink((double)cut.bytes);
+    });
+    AdvanceIndex index;
+    double build_time = benchSeconds([&]() {
+        index.build(font, text, scale);
+        benchSink(index.width());
+    });
+    Ellipsis indexed;
+    double ellipsize_time = benchSeconds([&]() {
+        for (size_t q = 0; q < queries; ++q)
+            indexed = index.ellipsize(max_width + (float)(q % 7), mark_width);
+        benchSink((double)indexed.bytes);
+    });
+
+    const float width = index.width();
+    double linear_time = benchSeconds([&]() {
+        size_t sum = 0;
+        for (size_t q = 0; q < queries; ++q) {
+            float x = width * (float)((q * 7919) % queries) / (float)queries;
+            size_t caret = 0;
+            while (caret < index.size() && index.penX(caret + 1) <= x)
+                ++caret;
+            sum += caret;
+        }
+        benchSink((double)sum);
+    });
+    double search_time = benchSeconds([&]() {
+        size_t sum = 0;
+        for (size_t q = 0; q < queries; ++q)
+            sum += index.charAt(width * (float)((q * 7919) % queries) / (float)queries);
+        benchSink((double)sum);
+    });
+
+    std::cout << std::fixed << std::setprecision(2)
+              << "  ellipsis: full layout + scan            " << layout_time * 1e6 << " us" << std::endl
+              << "  ellipsis: ellipsizeText                 " << scan_time * 1e6 << " us" << std::endl
+              << "  AdvanceIndex::build                     " << build_time * 1e6 << " us" << std::endl
+              << "  ellipsis: AdvanceIndex::ellipsize       " << ellipsize_time / queries * 1e6 << " us" << std::endl
+              << "  hit test: linear scan                   " << linear_time / queries * 1e6 << " us" << std::endl
+              << "  hit test: AdvanceIndex::charAt          " << search_time / queries * 1e6 << " us" << std::endl
+              << "  kept " << cut.codepoints << " codepoints (" << kept << " by the scan, "
+              << index.ellipsize(max_width, mark_width).codepoints << " by the index)" << std::endl;
+}
+
+// a scrolling log viewer: per frame cost of VirtualTextView (update plus
+// emit of the visible lines) across document sizes, against laying out
+// every line of the largest document once
+// ------------------------------------------------------------------------
+inline void benchTextView(const Font& font) {
+    const size_t sizes[] = { 1000, 20000, 200000 };
+    const size_t frames = 500;
+    const float scale = 0.15f;
+    const float view_height = 1000.0f;
+    std::cout << "virtualized text view (" << view_height << " px viewport, " << frames << " frames scrolling 2 lines each)" << std::endl;
+
+    std::vector<uint32_t> words = benchCorpusAscii(4096);
+    std::string text;
+    for (size_t line = 0; line < sizes[2]; ++line) {
+        text += std::to_string(line) + " INFO ";
+        size_t length = 20 + line * 7919 % 60;
+        size_t offset = line * 104729 % (words.size() - length);
+        for (size_t i = 0; i < length; ++i)
+            text += (char)words[offset + i];
+        text += '\n';
+    }
+    text.pop_back();
+
+    std::vector<float> vertices;
+    std::vector<PageRange> ranges;
+    for (size_t lines : sizes) {
+        size_t bytes = 0;
+        for (size_t newlines = 0; newlines < lines && bytes < text.size(); ++bytes)
+            newlines += text[bytes] == '\n';
+        VirtualTextView view(font, scale);
+        view.setText(std::string_view(text).substr(0, lines == sizes[2] ? text.size() : bytes - 1));
+        double top = 0.0;
+        size_t emitted = 0;
+        double seconds = benchSeconds([&]() {
+            for (size_t frame = 0; frame < frames; ++frame) {
+                top = std::fmod(top + 2.0 * view.lineHeight(), view.contentHeight() - view_height);
+                view.setViewport(top, view_height);
+                view.update();
+                vertices.clear();
+                ranges.clear();
+                view.emit(0.0f, view_height, vertices, &ranges);
+                emitted = vertices.size();
+            }
+            benchSink((double)vertices.size());
+        }, 3);
+        std::cout << std::fixed << std::setprecision(1) << "  " << std::setw(6) << view.lineCount() << " lines: "
+                  << seconds / frames * 1e6 << " us per frame, " << emitted * sizeof(float) / 1024 << " KB emitted, "
+                  << view.slotCount() << " slots" << std::endl;
+    }
+
+    std::vector<float> line_vertices(VIEW_COLUMNS * LAYOUT_QUAD_FLOATS);
+    double full_time = benchSeconds([&]() {
+        size_t glyphs = 0, begin = 0;
+        while (begin <= text.size()) {
+            size_t end = std::min(text.find('\n', begin), text.size());
+            LayoutTarget target(line_vertices.data(), VIEW_COLUMNS);
+            glyphs += layoutText(font, std::string_view(text).substr(begin, end - begin), 0.0f, 0.0f, scale, target);
+            begin = end + 1;
+        }
+        benchSink((double)glyphs);
+    }, 1);
+    std::cout << "  every line of " << sizes[2] << " laid out once: " << std::setprecision(1) << full_time * 1e3 << " ms" << std::endl;
+}
+
+// a text-heavy screen laid out as quads (4 vertices of 8 floats) and as
+// GlyphInstances for the instanced path: CPU fill rate and bytes uploaded.
+// measureText() walks the same glyphs and kerning without writing anything,
+// the floor the fill of either format cannot go below
+// ------------------------------------------------------------------------
+inline void benchInstances(const Font& font) {
+    const size_t length = 64 * 1024;
+    std::string text = benchCorpusUtf8(benchCorpusAscii(length), length);
+    std::vector<float> vertices(text.size() * LAYOUT_QUAD_FLOATS);
+    std::vector<GlyphInstance> instances(text.size());
+    std::vector<PageRange> ranges(text.size());
+    size_t glyphs = 0;
+    std::cout << "instanced glyphs (" << text.size() / 1024 << " KB of text)" << std::endl;
+
+    double quad_time = benchSeconds([&]() {
+        LayoutTarget target(vertices.data(), text.size(), ranges.data(), ranges.size());
+        glyphs = layoutText(font, text, 0.0f, 0.0f, 0.25f, target);
+        benchSink(vertices[glyphs * LAYOUT_QUAD_FLOATS - 1]);
+    });
+    double instance_time = benchSeconds([&]() {
+        LayoutTarget target = LayoutTarget::instanced(instances.data(), text.size(), ranges.data(), ranges.size());
+        glyphs = layoutText(font, text, 0.0f, 0.0f, 0.25f, target);
+        benchSink(instances[glyphs - 1].uv[3]);
+    });
+    double measure_time = benchSeconds([&]() {
+        benchSink(measureText(font, text, 0.25f).width);
+    });
+    const size_t quad_bytes = LAYOUT_QUAD_FLOATS * sizeof(float);
+    benchReport("layoutText, quads", quad_time, (double)glyphs, "glyphs");
+    benchReport("layoutText, instances", instance_time, (double)glyphs, "glyphs");
+    benchReport("measureText (no stores)", measure_time, (double)glyphs, "glyphs");
+    std::cout << "  " << quad_bytes << " B per glyph as quads, " << sizeof(GlyphInstance) << " B as an instance ("
+              << std::setprecision(1) << (double)quad_bytes / sizeof(GlyphInstance) << "x less upload), "
+              << glyphs * quad_bytes / 1024 << " KB vs " << glyphs * sizeof(GlyphInstance) / 1024 << " KB" << std::endl;
+}
+
+// the float vertex format (32 bytes) against compact vertices (8, or 12
+// with color): bytes per glyph, layout fill rate and the copy an upload
+// makes (--bench has no GL context; glBufferSubData costs at least this copy)
+// ------------------------------------------------------------------------
+inline void benchCompactVertices(const Font& font) {
+    const size_t length = 64 * 1024;
+    std::string text = benchCorpusUtf8(benchCorpusAscii(length), length);
+    std::vector<float> vertices(text.size() * LAYOUT_QUAD_FLOATS);
+    std::vector<unsigned char> compact(text.size() * LAYOUT_QUAD_VERTICES * LAYOUT_COMPACT_COLOR_BYTES);
+    std::vector<unsigned char> upload(vertices.size() * sizeof(float));
+    std::vector<PageRange> ranges(text.size());
+    std::cout << "compact vertices (" << text.size() / 1024 << " KB of text)" << std::endl;
+
+    struct Format { const char* name; size_t stride; };
+    const Format formats[] = {
+        { "float, 32 B vertex", LAYOUT_VERTEX_FLOATS * sizeof(float) },
+        { "compact, 8 B vertex", LAYOUT_COMPACT_VERTEX_BYTES },
+        { "compact + RGBA8, 12 B vertex", LAYOUT_COMPACT_COLOR_BYTES },
+    };
+    for (const Format& format : formats) {
+        size_t glyphs = 0;
+        auto layout = [&]() {
+            LayoutTarget target(vertices.data(), text.size(), ranges.data(), ranges.size());
+            if (format.stride != LAYOUT_VERTEX_FLOATS * sizeof(float))
+                target = LayoutTarget::compactQuads(compact.data(), text.size(), ranges.data(), ranges.size(),
+                                                    format.stride == LAYOUT_COMPACT_COLOR_BYTES);
+            glyphs = layoutText(font, text, 0.0f, 0.0f, 0.25f, target);
+        };
+        double layout_time = benchSeconds([&]() {
+            layout();
+            benchSink((double)glyphs);
+        });
+        const size_t bytes = glyphs * LAYOUT_QUAD_VERTICES * format.stride;
+        const unsigned char* source = format.stride == LAYOUT_VERTEX_FLOATS * sizeof(float)
+                                          ? reinterpret_cast<const unsigned char*>(vertices.data()) : compact.data();
+        double copy_time = benchSeconds([&]() {
+            memcpy(upload.data(), source, bytes);
+            benchSink(upload[bytes / 2]);
+        });
+        std::cout << "  " << std::left << std::setw(30) << format.name << std::right << std::setw(4)
+                  << LAYOUT_QUAD_VERTICES * format.stride << " B per glyph, " << std::setw(6) << bytes / 1024 << " KB, layout "
+                  << std::fixed << std::setprecision(2) << glyphs / layout_time / 1e6 << " Mglyphs/s, upload copy "
+                  << copy_time * 1e6 << " us" << std::endl;
+    }
+}
+
+// vertex pulling records (8 bytes, glyph index and pen) against instances:
+// layout fill rate, per-frame upload copy and the one-time glyph table
+// ------------------------------------------------------------------------
+inline void benchGlyphPulling(const Font& font) {
+    const size_t length = 64 * 1024;
+    std::string text = benchCorpusUtf8(benchCorpusAscii(length), length);
+    std::vector<GlyphInstance> instances(text.size());
+    std::vector<PulledGlyph> pulled(text.size());
+    std::vector<unsigned char> upload(text.size() * sizeof(GlyphInstance));
+    std::vector<PageRange> ranges(text.size());
+    size_t glyphs = 0;
+    std::cout << "vertex pulling (" << text.size() / 1024 << " KB of text)" << std::endl;
+
+    double instance_time = benchSeconds([&]() {
+        LayoutTarget target = LayoutTarget::instanced(instances.data(), text.size(), ranges.data(), ranges.size());
+        glyphs = layoutText(font, text, 0.0f, 0.0f, 0.25f, target);
+        benchSink(instances[glyphs - 1].uv[3]);
+    });
+    double pulled_time = benchSeconds([&]() {
+        LayoutTarget target = LayoutTarget::pulledGlyphs(pulled.data(), text.size(), ranges.data(), ranges.size());
+        glyphs = layoutText(font, text, 0.0f, 0.0f, 0.25f, target);
+        benchSink(pulled[glyphs - 1].pen_x);
+    });
+    double instance_copy = benchSeconds([&]() {
+        memcpy(upload.data(), instances.data(), glyphs * sizeof(GlyphInstance));
+        benchSink(upload[glyphs]);
+    });
+    double pulled_copy = benchSeconds([&]() {
+        memcpy(upload.data(), pulled.data(), glyphs * sizeof(PulledGlyph));
+        benchSink(upload[glyphs]);
+    });
+    benchReport("layoutText, instances", instance_time, (double)glyphs, "glyphs");
+    benchReport("layoutText, pulled records", pulled_time, (double)glyphs, "glyphs");
+    std::cout << "  " << sizeof(GlyphInstance) << " B per instance, " << sizeof(PulledGlyph) << " B per record: "
+              << glyphs * sizeof(GlyphInstance) / 1024 << " KB vs " << glyphs * sizeof(PulledGlyph) / 1024
+              << " KB, upload copy " << std::fixed << std::setprecision(2) << instance_copy * 1e6 << " us vs "
+              << pulled_copy * 1e6 << " us" << std::endl;
+    const size_t table_row = 8 * sizeof(float);     // plane bounds and UV rect, see msdf_glyph_pulling.h
+    std::cout << "  glyph table, uploaded once: " << font.glyphs().glyphCount() << " glyphs, "
+              << font.glyphs().glyphCount() * table_row / 1024 << " KB" << std::endl;
+}
+
+// layoutBatch() over a frame of HMI labels on 1, 2, 4 and N threads (more
+// threads than cores only time the pool's overhead); every run is compared
+// byte for byte against the single-threaded one. What bounds the scaling is
+// measured on one thread: the serial slice carving, the pool's dispatch and
+// the vertex stores against a plain memset of the same bytes
+// ------------------------------------------------------------------------
+inline void benchBatchLayout(const Font& font) {
+    const size_t label_count = 20000;
+    std::string corpus = benchCorpusUtf8(benchCorpusAscii(4096), 4096);
+    std::vector<LabelDesc> labels(label_count);
+    size_t bytes = 0;
+    for (size_t i = 0; i < label_count; ++i) {
+        size_t length = 8 + (i * 7919) % 57;    // 8 to 64 characters
+        size_t offset = (i * 104729) % (corpus.size() - length);
+        labels[i].font = &font;
+        labels[i].text = std::string_view(corpus).substr(offset, length);
+        labels[i].x = (float)(i % 16) * 64.0f;
+        labels[i].y = (float)(i / 16 % 64) * 16.0f;
+        labels[i].scale = 0.2f;
+        bytes += length;
+    }
+    FrameArena arena(bytes * (LAYOUT_QUAD_FLOATS * sizeof(float) + sizeof(PageRange)) + label_count * sizeof(LabelSlice) + 1024);
+    FrameArena reference_arena(arena.capacity());
+    unsigned cores = texelBlocksThreads(0);
+    std::cout << "batch layout (" << label_count << " labels, " << bytes / 1024 << " KB of text, "
+              << cores << " hardware threads)" << std::endl;
+
+    WorkerPool single(1);
+    LayoutBatch reference = layoutBatch(labels.data(), label_count, reference_arena, single);
+
+    std::vector<unsigned> thread_counts = { 1, 2, 4 };
+    if (std::find(thread_counts.begin(), thread_counts.end(), cores) == thread_counts.end()) {
+        thread_counts.push_back(cores);
+        std::sort(thread_counts.begin(), thread_counts.end());
+    }
+    double base = 0.0;
+    for (unsigned threads : thread_counts) {
+        WorkerPool pool(threads);
+        LayoutBatch batch;
+        double seconds = benchSeconds([&]() {
+            arena.reset();
+            batch = layoutBatch(labels.data(), label_count, arena, pool);
+            benchSink((double)batch.glyph_count);
+        });
+        auto nothing = [](size_t, size_t) {};
+        double dispatch = benchSeconds([&]() { pool.run(label_count, BATCH_LAYOUT_GRAIN, nothing); }, 50);
+        if (base == 0.0)
+            base = seconds;
+        bool identical = !batch.empty() && batch.glyph_count == reference.glyph_count &&
+                         memcmp(batch.labels, reference.labels, label_count * sizeof(LabelSlice)) == 0;
+        for (size_t i = 0; identical && i < label_count; ++i) {
+            const LabelSlice& slice = batch.labels[i];
+            identical = memcmp(batch.vertices + (size_t)slice.first_vertex * LAYOUT_VERTEX_FLOATS,
+                               reference.vertices + (size_t)slice.first_vertex * LAYOUT_VERTEX_FLOATS,
+                               slice.glyph_count * LAYOUT_QUAD_FLOATS * sizeof(float)) == 0 &&
+                        memcmp(batch.ranges + slice.first_range, reference.ranges + slice.first_range,
+                               slice.range_count * sizeof(PageRange)) == 0;
+        }
+        benchReport("layoutBatch, " + std::to_string(threads) + " threads" + (threads > cores ? " (oversubscribed)" : ""),
+                    seconds, (double)label_count, "labels");
+        std::cout << "    speedup " << std::setprecision(2) << base / seconds << "x, "
+                  << (identical ? "identical to" : "DIFFERS from") << " 1 thread, dispatch "
+                  << std::setprecision(1) << dispatch * 1e6 << " us" << std::endl;
+    }
+
+    // the carving loop and the glyph count sum of layoutBatch() run on the
+    // calling thread: Amdahl's bound for the pool
+    std::vector<LabelSlice> carved(reference.labels, reference.labels + label_count);
+    double serial = benchSeconds([&]() {
+        size_t slots = 0, glyphs = 0;
+        for (size_t i = 0; i < label_count; ++i) {
+            carved[i].first_vertex = (uint32_t)(slots * LAYOUT_QUAD_VERTICES);
+            carved[i].first_range = (uint32_t)slots;
+            slots += labels[i].text.size();
+        }
+        for (size_t i = 0; i < label_count; ++i)
+            glyphs += carved[i].glyph_count;
+        benchSink((double)(slots + glyphs));
+    }, 50);
+    const size_t vertex_bytes = reference.glyph_count * LAYOUT_QUAD_FLOATS * sizeof(float);
+    std::vector<unsigned char> store(vertex_bytes);
+    double fill = benchSeconds([&]() {
+        memset(store.data(), (int)reference.glyph_count, store.size());
+        benchSink((double)store[store.size() / 2]);
+    });
+    double fraction = serial / base;
+    std::cout << "    serial part " << std::setprecision(2) << fraction * 100.0 << "%: at most "
+              << 1.0 / (fraction + (1.0 - fraction) / cores) << "x on " << cores << " cores, "
+              << 1.0 / (fraction + (1.0 - fraction) / 16) << "x on 16" << std::endl;
+    std::cout << "    vertex stores " << std::setprecision(2) << vertex_bytes / base / 1e9 << " GB/s on 1 thread, memset "
+              << vertex_bytes / fill / 1e9 << " GB/s" << std::endl;
+}
+
+inline int runBenchmarks(const Font& font) {
+    const AtlasFile& atlas = font.atlas();
+    benchGlyphLookup(atlas);
+    benchKerning(atlas);
+    benchGlyphLayout(atlas, 3000);
+    benchGlyphLayout(atlas, 20000);
+    benchTexelBlocks(atlas);
+    benchLayoutTarget(font);
+    benchQuadEmit(font);
+    benchUtf8Decode(font);
+    benchParagraphLayout(font);
+    benchTextEdit(font);
+    benchMeasure(font);
+    benchAdvanceIndex(font);
+    benchTextView(font);
+    benchInstances(font);
+    benchCompactVertices(font);
+    benchGlyphPulling(font);
+    benchBatchLayout(font);
+    return 0;
+}
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef MSDF_COMPACT_VERTICES_H
+#define MSDF_COMPACT_VERTICES_H
+
+// GL side of the compact glyph vertex (LayoutTarget::compactQuads()): 2D
+// positions as int16 in 1/LAYOUT_COMPACT_SUBPIXEL px relative to the layout
+// origin, UVs as unorm16 and, optionally, an RGBA8 color. z and the per
+// vertex color of the float format are never used by the MSDF shaders, so a
+// vertex shrinks from 32 to 8 (12) bytes. shaders/4.2.texture_compact.vs
+// takes the origin of the label being drawn in labelOrigin.
+//
+// The attribute locations match 4.2.texture.vs (0 position, 1 color,
+// 2 texcoords); without the color stream, attribute 1 stays disabled and
+// reads the current generic value.
+
+#include <glad/gl.h>
+
+#include <msdf_text_layout.h>
+
+#include <cstddef>
+
+// point attributes 0..2 of the bound vertex array at the compact vertices
+// in the bound GL_ARRAY_BUFFER
+// ------------------------------------------------------------------------
+inline void compactVertexAttributes(bool withColor) {
+    const GLsizei stride = (GLsizei)(withColor ? LAYOUT_COMPACT_COLOR_BYTES : LAYOUT_COMPACT_VERTEX_BYTES);
+    // position attribute
+    glVertexAttribPointer(0, 2, GL_SHORT, GL_FALSE, stride, (void*)0);
+    glEnableVertexAttribArray(0);
+    // texture coord attribute
+    glVertexAttribPointer(2, 2, GL_UNSIGNED_SHORT, GL_TRUE, stride, (void*)(2 * sizeof(int16_t)));
+    glEnableVertexAttribArray(2);
+    // color attribute
+    if (withColor) {
+        glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (void*)(4 * sizeof(int16_t)));
+        glEnableVertexAttribArray(1);
+    } else {
+        glDisableVertexAttribArray(1);
+    }
+}
+
+// set the uniforms of 4.2.texture_compact.vs for a label laid out at (x, y)
+inline void compactVertexOrigin(unsigned int program, float x, float y) {
+    glUniform2f(glGetUniformLocation(program, "labelOrigin"), x, y);
+    glUniform1f(glGetUniformLocation(program, "positionStep"), 1.0f / LAYOUT_COMPACT_SUBPIXEL);
+}
+
+#endif
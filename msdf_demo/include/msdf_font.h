@@ -0,0 +1,172 @@
+#ifndef MSDF_FONT_H
+#define MSDF_FONT_H
+
+// A font is one binary atlas together with its texture pages: metrics and
+// glyph table come from the mapped atlas, the layout-side glyph records from
+// GlyphStore, the page textures from AtlasPages. FontRegistry owns every
+// loaded font and hands out FontIds, so several fonts (e.g. the mtsdf and
+// msdf test atlases) are resident at once.
+//
+// Threading: FontRegistry::load() may run on several worker threads at once.
+// Fonts are appended to a fixed array and published through an atomic count,
+// so lookups (font(), find(), fontCount()) never lock, the render loop calls
+// them per label and per draw.
+// A loaded font is immutable apart from its page textures, so layout can run
+// on any number of fonts in parallel through `const Font&`; page uploads and
+// release() belong to the GL thread.
+
+#include <msdf_atlas_bin.h>
+#include <msdf_atlas_pages.h>
+#include <msdf_glyph_store.h>
+
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+
+typedef uint32_t FontId;
+
+const FontId FONT_INVALID = 0xFFFFFFFF;
+const uint32_t FONT_REGISTRY_CAPACITY = 64;
+
+class Font
+{
+public:
+    Font() {}
+
+    Font(const Font&) = delete;
+    Font& operator=(const Font&) = delete;
+
+    // map the precompiled atlas; when it is missing (first run, or the offline
+    // step was skipped) or was compiled from a different msdf-atlas-gen JSON,
+    // compile it from the JSON. Without the JSON the atlas is used as is, and
+    // multi-page atlases (offline --compile-atlas) are never recompiled here. No GL calls
+    // ------------------------------------------------------------------------
+    bool load(const std::string& name, const std::string& atlasPath, const std::string& jsonPath)
+    {
+        font_name = name;
+        uint64_t source_hash = 0, source_size = 0;
+        bool stale = false;
+        if (atlas_file.open(atlasPath) && atlas_file.pageCount() == 1 && atlasSourceHash({ jsonPath }, source_hash, source_size))
+            stale = !atlas_file.matchesSource(source_hash, source_size);
+        if (!atlas_file.isOpen() || stale) {
+            atlas_file.close();
+            std::cout << "Compiling " << jsonPath << " into " << atlasPath << std::endl;
+            if (!compileAtlasBinary(jsonPath, atlasPath) || !atlas_file.open(atlasPath))
+                return false;
+        }
+        glyph_store.build(atlas_file);
+        ascii_metrics.build(glyph_store, atlas_file.glyphTable());
+        atlas_pages.init(atlas_file);
+        return true;
+    }
+
+    const std::string& name() const { return font_name; }
+    const AtlasFile& atlas() const { return atlas_file; }
+    // font metrics (line height, ascender, ...) and atlas type, in atlas pixels
+    const AtlasBinHeader& metrics() const { return atlas_file.header(); }
+
+    // glyph index of a codepoint (or of the fallback glyph) into glyphs();
+    // GLYPH_MISSING for an empty font
+    uint16_t glyphIndex(uint32_t codepoint) const { return atlas_file.glyphTable().lookupOrFallback(codepoint); }
+    // hot/cold glyph records for layout
+    const GlyphStore& glyphs() const { return glyph_store; }
+    // dense ASCII advance and bounds tables for measuring
+    const AsciiMetrics& asciiMetrics() const { return ascii_metrics; }
+
+    // atlas record of a codepoint, or of the fallback glyph; nullptr for an empty font
+    const AtlasBinGlyph* glyph(uint32_t codepoint) const { return atlas_file.glyphOrFallback(codepoint); }
+    // kerning adjustment between `left` and the glyph of `right`, in atlas pixels
+    float kerning(const AtlasBinGlyph* left, uint32_t right) const { return atlas_file.kerningAdvance(left, right); }
+    float kerning(const AtlasBinGlyph* left, const AtlasBinGlyph* right) const { return atlas_file.kerningAdvance(left, right); }
+
+    // page textures; not thread safe, use from the GL thread (loadTexels() excepted)
+    AtlasPages& pages() { return atlas_pages; }
+    const AtlasPages& pages() const { return atlas_pages; }
+
+private:
+    std::string font_name;
+    AtlasFile atlas_file;
+    GlyphStore glyph_store;
+    AsciiMetrics ascii_metrics;
+    AtlasPages atlas_pages;
+};
+
+class FontRegistry
+{
+public:
+    FontRegistry() {}
+
+    FontRegistry(const FontRegistry&) = delete;
+    FontRegistry& operator=(const FontRegistry&) = delete;
+
+    // load a font and register it under `name`; returns its id, or FONT_INVALID.
+    // Loading a name twice returns the existing id. Safe to call from several
+    // threads, the atlas is opened outside the lock
+    // ------------------------------------------------------------------------
+    FontId load(const std::string& name, const std::string& atlasPath, const std::string& jsonPath)
+    {
+        FontId existing = find(name);
+        if (existing != FONT_INVALID)
+            return existing;
+
+        std::unique_ptr<Font> font(new Font());
+        if (!font->load(name, atlasPath, jsonPath)) {
+            std::cout << "ERROR::FONT::NOT_LOADED: " << name << std::endl;
+            return FONT_INVALID;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        uint32_t count = font_count.load(std::memory_order_relaxed);
+        for (uint32_t i = 0; i < count; ++i)
+            if (fonts[i]->name() == name)
+                return (FontId)i;
+        if (count == FONT_REGISTRY_CAPACITY) {
+            std::cout << "ERROR::FONT::REGISTRY_FULL: " << name << std::endl;
+            return FONT_INVALID;
+        }
+        fonts[count] = std::move(font);
+        font_count.store(count + 1, std::memory_order_release);
+        return (FontId)count;
+    }
+    // ------------------------------------------------------------------------
+    FontId find(const std::string& name) const
+    {
+        uint32_t count = fontCount();
+        for (uint32_t i = 0; i < count; ++i)
+            if (fonts[i]->name() == name)
+                return (FontId)i;
+        return FONT_INVALID;
+    }
+    // the font of an id; the pointer stays valid until the registry is destroyed
+    // ------------------------------------------------------------------------
+    Font* font(FontId id)
+    {
+        return id < fontCount() ? fonts[id].get() : nullptr;
+    }
+    const Font* font(FontId id) const
+    {
+        return id < fontCount() ? fonts[id].get() : nullptr;
+    }
+    uint32_t fontCount() const
+    {
+        return font_count.load(std::memory_order_acquire);
+    }
+    // delete the page textures of every font (GL thread)
+    // ------------------------------------------------------------------------
+    void release()
+    {
+        uint32_t count = fontCount();
+        for (uint32_t i = 0; i < count; ++i)
+            fonts[i]->pages().release();
+    }
+
+private:
+    std::mutex mutex;                                   // serializes load(); lookups take no lock
+    std::unique_ptr<Font> fonts[FONT_REGISTRY_CAPACITY];    // indexed by FontId, a slot is never rewritten
+    std::atomic<uint32_t> font_count{ 0 };              // published after the slot is filled
+};
+
+#endif
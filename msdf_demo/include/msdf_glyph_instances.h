@@ -0,0 +1,125 @@
+#ifndef MSDF_GLYPH_INSTANCES_H
+#define MSDF_GLYPH_INSTANCES_H
+
+// GL side of the instanced glyph path: a stream of GlyphInstance records,
+// one per glyph, expanded over a unit quad by
+// shaders/4.2.texture_instanced.vs. A glyph costs 36 bytes of upload instead
+// of four 32-byte vertices, and layout writes 9 values per glyph instead of 32.
+//
+// The records are not instance attributes: they sit in a buffer texture (9
+// R32UI texels each) and are drawn through the shared quad index buffer
+// (msdf_quad_indices.h), whose indices number the corners of glyph g
+// 4g .. 4g + 3, so gl_VertexID >> 2 picks the record and gl_VertexID & 3 the
+// corner. glDrawArraysInstanced over a 4 vertex strip was 2.5-3.5x slower
+// than the same glyphs as indexed quads on Mesa llvmpipe, which runs each
+// instance as its own small draw, and a base instance (instead of pointing
+// the attributes at every range) did not help; pulled by vertex id, the
+// records draw as fast as the quads, and a range is only an index offset.
+// All calls need the GL context current.
+
+#include <glad/gl.h>
+
+#include <msdf_atlas_pages.h>
+#include <msdf_quad_indices.h>
+#include <msdf_text_layout.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+
+const GLuint INSTANCE_RECORD_UNIT = 3;  // texture unit of the record buffer texture; atlas pages stay on 0
+const size_t INSTANCE_RECORD_TEXELS = sizeof(GlyphInstance) / sizeof(uint32_t);
+const size_t INSTANCE_STYLES = 8;       // size of styleColors[] in the shader
+
+class GlyphInstanceBuffer
+{
+public:
+    GlyphInstanceBuffer() {}
+    ~GlyphInstanceBuffer() { release(); }
+
+    GlyphInstanceBuffer(const GlyphInstanceBuffer&) = delete;
+    GlyphInstanceBuffer& operator=(const GlyphInstanceBuffer&) = delete;
+
+    // ------------------------------------------------------------------------
+    void create()
+    {
+        GLint max_texels = 0;
+        glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &max_texels);
+        max_instances = (size_t)max_texels / INSTANCE_RECORD_TEXELS;
+
+        glGenVertexArrays(1, &vao);
+        glGenBuffers(1, &record_buffer);
+        glBindBuffer(GL_TEXTURE_BUFFER, record_buffer);
+        glBufferData(GL_TEXTURE_BUFFER, sizeof(GlyphInstance), nullptr, GL_DYNAMIC_DRAW);
+        glGenTextures(1, &record_texture);
+        glBindTexture(GL_TEXTURE_BUFFER, record_texture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_R32UI, record_buffer);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+        glBindVertexArray(vao);
+        indices.create(64);
+        glBindVertexArray(0);
+    }
+    // ------------------------------------------------------------------------
+    void release()
+    {
+        if (vao == 0)
+            return;
+        indices.release();
+        glDeleteVertexArrays(1, &vao);
+        glDeleteTextures(1, &record_texture);
+        glDeleteBuffers(1, &record_buffer);
+        vao = record_buffer = record_texture = 0;
+    }
+
+    // stream this frame's instances into the orphaned buffer (binds the
+    // vertex array, whose index buffer grows with them); false when they do
+    // not fit GL_MAX_TEXTURE_BUFFER_SIZE (7281 glyphs at the GL 3.3 minimum,
+    // millions on current drivers)
+    // ------------------------------------------------------------------------
+    bool upload(const GlyphInstance* instances, size_t count)
+    {
+        const bool fits = count <= max_instances;
+        if (!fits) {
+            std::cout << "ERROR::GLYPH_INSTANCES::TOO_MANY_GLYPHS: " << count << " (at most " << max_instances << ")" << std::endl;
+            count = 0;
+        }
+        glBindBuffer(GL_TEXTURE_BUFFER, record_buffer);
+        glBufferData(GL_TEXTURE_BUFFER, (count ? count : 1) * sizeof(GlyphInstance), count ? instances : nullptr, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+        glBindVertexArray(vao);
+        indices.reserve(count);
+        instance_count = count;
+        return fits;
+    }
+
+    // bind the vertex array and the records for draw() with `program`
+    // (4.2.texture_instanced.vs) in use; the caller binds the page textures
+    // on unit 0
+    // ------------------------------------------------------------------------
+    void bind(unsigned int program) const
+    {
+        glBindVertexArray(vao);
+        glActiveTexture(GL_TEXTURE0 + INSTANCE_RECORD_UNIT);
+        glBindTexture(GL_TEXTURE_BUFFER, record_texture);
+        glActiveTexture(GL_TEXTURE0);
+        glUniform1i(glGetUniformLocation(program, "glyphInstances"), (GLint)INSTANCE_RECORD_UNIT);
+    }
+
+    // draw `range.count` instances from `range.first`
+    // ------------------------------------------------------------------------
+    void draw(const PageRange& range) const
+    {
+        if (range.first + range.count > instance_count)
+            return;
+        indices.draw({ range.page, range.first * (uint32_t)LAYOUT_QUAD_VERTICES, range.count * (uint32_t)LAYOUT_QUAD_VERTICES });
+    }
+
+private:
+    GLuint vao = 0, record_buffer = 0, record_texture = 0;
+    QuadIndexBuffer indices;
+    size_t max_instances = 0;
+    size_t instance_count = 0;
+};
+
+#endif
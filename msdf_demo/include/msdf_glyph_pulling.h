@@ -0,0 +1,180 @@
+#ifndef MSDF_GLYPH_PULLING_H
+#define MSDF_GLYPH_PULLING_H
+
+// GL side of vertex pulling (LayoutTarget::pulledGlyphs()). The glyph table
+// of a font is uploaded once, as a buffer texture of two RGBA32F texels per
+// glyph: the plane bounds in planeUnit() steps and the UV rect. Each frame
+// uploads only the 8 byte PulledGlyph records (pen x and glyph index) into
+// a second buffer texture. shaders/4.2.texture_pulled.vs has no vertex
+// attributes: gl_InstanceID picks the record (from firstGlyph), the record
+// picks the table row, and gl_VertexID picks the corner of a 4 vertex
+// triangle strip. A glyph costs 8 bytes of upload instead of 36 as an
+// instance or 128 as a quad.
+//
+// Records hold the pen relative to the layout origin and no y: the draw
+// gives the origin and the scale of the label (pulledGlyphOrigin()), so the
+// records of a string can be drawn anywhere without laying it out again.
+// Buffer textures are core since GL 3.1; "msdf_demo --smoke" checks the
+// pulled glyphs against quads, headless on Mesa llvmpipe (see main()).
+// All calls need the GL context current.
+
+#include <glad/gl.h>
+
+#include <msdf_atlas_pages.h>
+#include <msdf_glyph_store.h>
+#include <msdf_text_layout.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+const GLuint PULLING_TABLE_UNIT = 1;    // texture units of the two buffer textures; atlas pages stay on 0
+const GLuint PULLING_RECORD_UNIT = 2;
+const size_t PULLING_TABLE_TEXELS = 2;  // per glyph: plane bounds, UV rect
+
+// the glyph table of one font, uploaded once
+class GlyphTableBuffer
+{
+public:
+    GlyphTableBuffer() {}
+    ~GlyphTableBuffer() { release(); }
+
+    GlyphTableBuffer(const GlyphTableBuffer&) = delete;
+    GlyphTableBuffer& operator=(const GlyphTableBuffer&) = delete;
+
+    // false when the table does not fit GL_MAX_TEXTURE_BUFFER_SIZE (65536
+    // texels, 32768 glyphs, at the GL 3.3 minimum)
+    // ------------------------------------------------------------------------
+    bool create(const GlyphStore& glyphs)
+    {
+        GLint max_texels = 0;
+        glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &max_texels);
+        size_t texels = (size_t)glyphs.glyphCount() * PULLING_TABLE_TEXELS;
+        if (texels > (size_t)max_texels) {
+            std::cout << "ERROR::GLYPH_TABLE::TOO_MANY_GLYPHS: " << glyphs.glyphCount() << std::endl;
+            return false;
+        }
+        std::vector<float> table(texels * 4);
+        for (uint32_t i = 0; i < glyphs.glyphCount(); ++i) {
+            const GlyphHot& hot = glyphs.hot()[i];
+            const GlyphCold& cold = glyphs.cold()[i];
+            const float row[8] = { (float)hot.pl, (float)hot.pb, (float)hot.pr, (float)hot.pt,
+                                   cold.u0, cold.v0, cold.u1, cold.v1 };
+            std::copy(row, row + 8, &table[i * 8]);
+        }
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+        glBufferData(GL_TEXTURE_BUFFER, table.size() * sizeof(float), table.data(), GL_STATIC_DRAW);
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_BUFFER, texture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, buffer);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+        plane_unit = glyphs.planeUnit();
+        table_bytes = table.size() * sizeof(float);
+        return true;
+    }
+    // ------------------------------------------------------------------------
+    void release()
+    {
+        if (buffer == 0)
+            return;
+        glDeleteTextures(1, &texture);
+        glDeleteBuffers(1, &buffer);
+        texture = buffer = 0;
+        table_bytes = 0;
+    }
+
+    GLuint textureId() const { return texture; }
+    float planeUnit() const { return plane_unit; }
+    size_t bytes() const { return table_bytes; }
+
+private:
+    GLuint buffer = 0, texture = 0;
+    float plane_unit = 1.0f;
+    size_t table_bytes = 0;
+};
+
+// the per-frame glyph records and the attribute-less vertex array they are
+// drawn with
+class PulledGlyphBuffer
+{
+public:
+    PulledGlyphBuffer() {}
+    ~PulledGlyphBuffer() { release(); }
+
+    PulledGlyphBuffer(const PulledGlyphBuffer&) = delete;
+    PulledGlyphBuffer& operator=(const PulledGlyphBuffer&) = delete;
+
+    // ------------------------------------------------------------------------
+    void create()
+    {
+        glGenVertexArrays(1, &vao);
+        glGenBuffers(1, &record_buffer);
+        glBindBuffer(GL_TEXTURE_BUFFER, record_buffer);
+        glBufferData(GL_TEXTURE_BUFFER, sizeof(PulledGlyph), nullptr, GL_DYNAMIC_DRAW);
+        glGenTextures(1, &record_texture);
+        glBindTexture(GL_TEXTURE_BUFFER, record_texture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32UI, record_buffer);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    }
+    // ------------------------------------------------------------------------
+    void release()
+    {
+        if (vao == 0)
+            return;
+        glDeleteVertexArrays(1, &vao);
+        glDeleteTextures(1, &record_texture);
+        glDeleteBuffers(1, &record_buffer);
+        vao = record_buffer = record_texture = 0;
+    }
+
+    // stream this frame's records into the orphaned buffer; the buffer
+    // texture follows the new storage
+    // ------------------------------------------------------------------------
+    void upload(const PulledGlyph* glyphs, size_t count)
+    {
+        glBindBuffer(GL_TEXTURE_BUFFER, record_buffer);
+        glBufferData(GL_TEXTURE_BUFFER, (count ? count : 1) * sizeof(PulledGlyph), glyphs, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    }
+
+    // bind the vertex array, the font's glyph table and the records for
+    // draw() with `program` (4.2.texture_pulled.vs) in use; the caller binds
+    // the page textures on unit 0
+    // ------------------------------------------------------------------------
+    void bind(unsigned int program, const GlyphTableBuffer& table)
+    {
+        glBindVertexArray(vao);
+        glActiveTexture(GL_TEXTURE0 + PULLING_TABLE_UNIT);
+        glBindTexture(GL_TEXTURE_BUFFER, table.textureId());
+        glActiveTexture(GL_TEXTURE0 + PULLING_RECORD_UNIT);
+        glBindTexture(GL_TEXTURE_BUFFER, record_texture);
+        glActiveTexture(GL_TEXTURE0);
+        glUniform1i(glGetUniformLocation(program, "glyphTable"), (GLint)PULLING_TABLE_UNIT);
+        glUniform1i(glGetUniformLocation(program, "glyphRecords"), (GLint)PULLING_RECORD_UNIT);
+        first_glyph = glGetUniformLocation(program, "firstGlyph");
+    }
+
+    // draw `range.count` records from `range.first`
+    // ------------------------------------------------------------------------
+    void draw(const PageRange& range) const
+    {
+        glUniform1i(first_glyph, (GLint)range.first);
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)range.count);
+    }
+
+private:
+    GLuint vao = 0, record_buffer = 0, record_texture = 0;
+    GLint first_glyph = -1;
+};
+
+// set the uniforms of 4.2.texture_pulled.vs for a label laid out at (x, y)
+// with `scale`
+inline void pulledGlyphOrigin(unsigned int program, const GlyphTableBuffer& table, float x, float y, float scale) {
+    glUniform2f(glGetUniformLocation(program, "labelOrigin"), x, y);
+    glUniform1f(glGetUniformLocation(program, "planeScale"), table.planeUnit() * scale);
+}
+
+#endif
@@ -0,0 +1,335 @@
+#ifndef MSDF_GLYPH_STORE_H
+#define MSDF_GLYPH_STORE_H
+
+// Layout-side glyph storage, built once from the atlas glyph and kerning
+// tables and split by access pattern into cache-line aligned arrays:
+//
+//   hot    GlyphHot, 16 bytes (4 per cache line): advance, quantized plane
+//          bounds and the glyph's kerning row and column; read for every
+//          character
+//   cold   GlyphCold (atlas UVs) and page; read for visible glyphs only
+//   pairs  kerning pairs grouped by left glyph and keyed by the right glyph
+//          index, with the start of every glyph's run, so a glyph's run ends
+//          where the next glyph's begins
+//   matrix the same pairs as a compact dense table: one row per glyph with a
+//          run, one column per glyph that is the right side of some pair,
+//          row and column 0 all zero for the rest
+//
+// kerning() reads both glyphs' hot records, which layout has already loaded,
+// and while the matrix stays within GLYPH_KERNING_MATRIX_CELLS (16 x 27 in
+// msdf_test2, 1.7 KB) it is one branchless load. Larger kerning sets search
+// the runs, after a zero row or column has rejected the pair without reading
+// them.
+//
+// Glyph indices are the atlas glyph indices (GlyphTable lookups).
+
+#include <msdf_atlas_bin.h>
+#include <msdf_glyph_table.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MSDF_GLYPH_STORE_SSE2 1
+#endif
+
+const size_t GLYPH_STORE_ALIGN = 64;    // cache line
+const uint32_t GLYPH_KERNING_MATRIX_CELLS = 16384;  // 64 KB of floats
+
+struct GlyphHot {
+    float advance;                      // atlas pixels
+    int16_t pl, pb, pr, pt;             // plane bounds in planeUnit() steps; all 0 for blank glyphs
+    uint16_t kerning_row;               // row * columns with a matrix, else the row; 0 when the
+                                        // glyph is the left side of no pair
+    uint16_t kerning_column;            // 0 when the glyph is the right side of no pair
+};
+
+struct GlyphCold {
+    float u0, v0, u1, v1;               // normalized atlas UVs
+};
+
+struct GlyphKerning {
+    uint16_t right;                     // right glyph index
+    uint16_t reserved;
+    float advance;                      // atlas pixels
+};
+
+static_assert(sizeof(GlyphHot) == 16, "GlyphHot must stay 16 bytes");
+static_assert(sizeof(GlyphCold) == 16, "GlyphCold must stay 16 bytes");
+static_assert(sizeof(GlyphKerning) == 8, "GlyphKerning must stay 8 bytes");
+
+class GlyphStore
+{
+public:
+    GlyphStore() {}
+
+    GlyphStore(const GlyphStore&) = delete;
+    GlyphStore& operator=(const GlyphStore&) = delete;
+
+    // glyphs sorted by codepoint (as in the atlas); kerning pairs whose left
+    // or right glyph is not in `glyphs` are dropped
+    // ------------------------------------------------------------------------
+    void build(const AtlasBinGlyph* glyphs, uint32_t glyphCount, const AtlasBinKerning* kerning, uint32_t kerningCount)
+    {
+        auto indexOf = [&](uint32_t codepoint) -> int64_t {
+            const AtlasBinGlyph* it = std::lower_bound(glyphs, glyphs + glyphCount, codepoint,
+                [](const AtlasBinGlyph& glyph, uint32_t cp) { return glyph.codepoint < cp; });
+            return (it != glyphs + glyphCount && it->codepoint == codepoint) ? it - glyphs : -1;
+        };
+
+        // pairs grouped by left glyph, ordered by right glyph within a run
+        struct Pair { uint32_t left; uint16_t right; float advance; };
+        std::vector<Pair> pairs;
+        for (uint32_t i = 0; i < kerningCount; ++i) {
+            int64_t left = indexOf(kerning[i].left);
+            int64_t right = indexOf(kerning[i].right);
+            if (left >= 0 && right >= 0)
+                pairs.push_back({ (uint32_t)left, (uint16_t)right, kerning[i].advance });
+        }
+        std::sort(pairs.begin(), pairs.end(), [](const Pair& a, const Pair& b) {
+            return a.left != b.left ? a.left < b.left : a.right < b.right;
+        });
+
+        // one quantization step for all plane bounds of the font
+        float max_bound = 0.0f;
+        for (uint32_t i = 0; i < glyphCount; ++i) {
+            max_bound = std::max(max_bound, std::max(std::fabs(glyphs[i].pl), std::fabs(glyphs[i].pr)));
+            max_bound = std::max(max_bound, std::max(std::fabs(glyphs[i].pb), std::fabs(glyphs[i].pt)));
+        }
+        plane_unit = max_bound > 0.0f ? max_bound / 32767.0f : 1.0f;
+
+        // matrix rows and columns, numbered from 1 in glyph order
+        std::vector<uint16_t> rows(glyphCount, 0), columns(glyphCount, 0);
+        uint32_t row_count = 1, column_count = 1;
+        for (const Pair& p : pairs) {
+            if (!rows[p.left])
+                rows[p.left] = (uint16_t)row_count++;
+            columns[p.right] = 1;
+        }
+        for (uint32_t i = 0; i < glyphCount; ++i)
+            if (columns[i])
+                columns[i] = (uint16_t)column_count++;
+        bool use_matrix = !pairs.empty() && (uint64_t)row_count * column_count <= GLYPH_KERNING_MATRIX_CELLS;
+
+        allocate(glyphCount, (uint32_t)pairs.size(), use_matrix ? row_count * column_count : 0);
+        if (use_matrix) {
+            for (uint16_t& row : rows)
+                row = (uint16_t)(row * column_count);
+            std::fill(kerning_matrix, kerning_matrix + row_count * column_count, 0.0f);
+            for (const Pair& p : pairs)
+                kerning_matrix[rows[p.left] + columns[p.right]] = p.advance;
+        }
+
+        size_t pair = 0;
+        for (uint32_t i = 0; i < glyphCount; ++i) {
+            const AtlasBinGlyph& glyph = glyphs[i];
+            GlyphHot& h = hot_glyphs[i];
+            h.advance = glyph.advance;
+            h.pl = h.pb = h.pr = h.pt = 0;
+            if (glyph.flags & ATLAS_GLYPH_VISIBLE) {
+                h.pl = quantize(glyph.pl);
+                h.pb = quantize(glyph.pb);
+                h.pr = quantize(glyph.pr);
+                h.pt = quantize(glyph.pt);
+                // keep tiny glyphs visible after rounding; quantize() stops
+                // at +-32767, so step pl down rather than pr past the top
+                if (h.pr == h.pl) {
+                    if (h.pl == INT16_MAX)
+                        h.pl = (int16_t)(h.pl - 1);
+                    else
+                        h.pr = (int16_t)(h.pl + 1);
+                }
+            }
+            h.kerning_row = rows[i];
+            h.kerning_column = columns[i];
+            kerning_runs[i] = (uint32_t)pair;
+            for (; pair < pairs.size() && pairs[pair].left == i; ++pair)
+                kerning_pairs[pair] = { pairs[pair].right, 0, pairs[pair].advance };
+
+            cold_glyphs[i] = { glyph.u0, glyph.v0, glyph.u1, glyph.v1 };
+            glyph_pages[i] = glyph.page;
+            glyph_codepoints[i] = glyph.codepoint;
+        }
+        // sentinel, ends the last glyph's kerning run
+        kerning_runs[glyphCount] = (uint32_t)pair;
+    }
+    // ------------------------------------------------------------------------
+    void build(const AtlasFile& atlas)
+    {
+        build(atlas.glyphs(), atlas.glyphCount(), atlas.kerning(), atlas.kerningCount());
+    }
+
+    // kerning adjustment in atlas pixels when glyph `right` follows `left`
+    // ------------------------------------------------------------------------
+    float kerning(uint16_t left, uint16_t right) const
+    {
+        uint32_t row = hot_glyphs[left].kerning_row;
+        uint32_t column = hot_glyphs[right].kerning_column;
+        if (kerning_matrix)
+            return kerning_matrix[row + column];
+        if (!row || !column)
+            return 0.0f;
+        const GlyphKerning* first = kerning_pairs + kerning_runs[left];
+        const GlyphKerning* last = kerning_pairs + kerning_runs[left + 1];
+        const GlyphKerning* it = std::lower_bound(first, last, right,
+            [](const GlyphKerning& pair, uint16_t index) { return pair.right < index; });
+        return (it != last && it->right == right) ? it->advance : 0.0f;
+    }
+
+    // pen advance from `glyph` in atlas pixels: its advance plus the kerning
+    // against the glyph before it (GLYPH_MISSING at the start of a line).
+    // Layout, paragraphs and measuring all advance through this
+    // ------------------------------------------------------------------------
+    float advance(uint16_t prevGlyph, uint16_t glyph) const
+    {
+        float pair = prevGlyph != GLYPH_MISSING ? kerning(prevGlyph, glyph) : 0.0f;
+        return hot_glyphs[glyph].advance + pair;
+    }
+
+    static bool visible(const GlyphHot& glyph) { return glyph.pr != glyph.pl; }
+
+    // quad corners x0, y0, x1, y1 of a glyph placed at pen (x, y); planeScale
+    // is planeUnit() times the text scale. The four int16 bounds are widened and
+    // scaled in one SSE2 step where available, a scalar int->float convert per
+    // bound otherwise costs more than the smaller record saves
+    // ------------------------------------------------------------------------
+    static void planeBounds(const GlyphHot& glyph, float x, float y, float planeScale, float* out)
+    {
+#ifdef MSDF_GLYPH_STORE_SSE2
+        __m128i bounds = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(&glyph.pl));
+        bounds = _mm_srai_epi32(_mm_unpacklo_epi16(bounds, bounds), 16);
+        __m128 corners = _mm_mul_ps(_mm_cvtepi32_ps(bounds), _mm_set1_ps(planeScale));
+        _mm_storeu_ps(out, _mm_add_ps(corners, _mm_setr_ps(x, y, x, y)));
+#else
+        out[0] = x + glyph.pl * planeScale;
+        out[1] = y + glyph.pb * planeScale;
+        out[2] = x + glyph.pr * planeScale;
+        out[3] = y + glyph.pt * planeScale;
+#endif
+    }
+
+    uint32_t glyphCount() const { return count; }
+    uint32_t kerningCount() const { return pair_count; }
+    // atlas pixels per quantized plane bound step
+    float planeUnit() const { return plane_unit; }
+
+    const GlyphHot* hot() const { return hot_glyphs; }
+    const GlyphCold* cold() const { return cold_glyphs; }
+    const uint8_t* pages() const { return glyph_pages; }
+    const uint32_t* codepoints() const { return glyph_codepoints; }
+
+    size_t memoryBytes() const { return storage_size; }
+
+private:
+    std::unique_ptr<unsigned char[]> storage;
+    size_t storage_size = 0;
+    uint32_t count = 0;
+    uint32_t pair_count = 0;
+    float plane_unit = 1.0f;
+
+    GlyphHot* hot_glyphs = nullptr;
+    GlyphCold* cold_glyphs = nullptr;
+    GlyphKerning* kerning_pairs = nullptr;
+    uint32_t* kerning_runs = nullptr;   // count + 1 (sentinel)
+    float* kerning_matrix = nullptr;    // nullptr when the runs are searched instead
+    uint8_t* glyph_pages = nullptr;
+    uint32_t* glyph_codepoints = nullptr;
+
+    int16_t quantize(float value) const
+    {
+        float steps = std::round(value / plane_unit);
+        return (int16_t)std::max(-32767.0f, std::min(32767.0f, steps));
+    }
+    // one block, every array starting on its own cache line
+    // ------------------------------------------------------------------------
+    void allocate(uint32_t glyphCount, uint32_t kerningCount, uint32_t matrixCells)
+    {
+        auto line = [](size_t bytes) { return (bytes + GLYPH_STORE_ALIGN - 1) & ~(GLYPH_STORE_ALIGN - 1); };
+        size_t hot_bytes = line(glyphCount * sizeof(GlyphHot));
+        size_t cold_bytes = line(glyphCount * sizeof(GlyphCold));
+        size_t pair_bytes = line(kerningCount * sizeof(GlyphKerning));
+        size_t run_bytes = line((glyphCount + 1) * sizeof(uint32_t));
+        size_t matrix_bytes = line(matrixCells * sizeof(float));
+        size_t page_bytes = line(glyphCount * sizeof(uint8_t));
+        size_t codepoint_bytes = line(glyphCount * sizeof(uint32_t));
+
+        storage_size = hot_bytes + cold_bytes + pair_bytes + run_bytes + matrix_bytes + page_bytes + codepoint_bytes;
+        storage.reset(new unsigned char[storage_size + GLYPH_STORE_ALIGN]);
+        unsigned char* base = storage.get();
+        base += (GLYPH_STORE_ALIGN - reinterpret_cast<uintptr_t>(base) % GLYPH_STORE_ALIGN) % GLYPH_STORE_ALIGN;
+
+        hot_glyphs = reinterpret_cast<GlyphHot*>(base);
+        cold_glyphs = reinterpret_cast<GlyphCold*>(base + hot_bytes);
+        base += hot_bytes + cold_bytes;
+        kerning_pairs = reinterpret_cast<GlyphKerning*>(base);
+        kerning_runs = reinterpret_cast<uint32_t*>(base + pair_bytes);
+        kerning_matrix = matrixCells ? reinterpret_cast<float*>(base + pair_bytes + run_bytes) : nullptr;
+        base += pair_bytes + run_bytes + matrix_bytes;
+        glyph_pages = base;
+        glyph_codepoints = reinterpret_cast<uint32_t*>(base + page_bytes);
+        count = glyphCount;
+        pair_count = kerningCount;
+    }
+};
+
+const size_t ASCII_ROW_START = 128;     // AsciiMetrics row of the first glyph on a line
+const size_t ASCII_ROW_OTHER = 129;     // no row: the previous glyph is not ASCII
+
+// per-font dense tables over ASCII for measuring: the pen advance of every
+// ASCII pair taken from GlyphStore::advance() (so sums match layout bit for
+// bit) and the plane bounds as floats, blank glyphs as an empty box
+// (+inf, +inf, -inf, -inf) that never widens a union. 129 x 128 advances, 66 KB
+class AsciiMetrics
+{
+public:
+    // ------------------------------------------------------------------------
+    void build(const GlyphStore& store, const GlyphTable& table)
+    {
+        complete = store.glyphCount() > 0;
+        for (uint32_t c = 0; c < 128; ++c) {
+            ascii_glyphs[c] = table.lookupOrFallback(c);
+            if (ascii_glyphs[c] == GLYPH_MISSING)
+                complete = false;
+        }
+        pair_advance.assign((ASCII_ROW_START + 1) * 128, 0.0f);
+        if (!complete)
+            return;
+
+        for (uint32_t c = 0; c < 128; ++c) {
+            const GlyphHot& hot = store.hot()[ascii_glyphs[c]];
+            float* bounds = plane_bounds[c];
+            if (GlyphStore::visible(hot)) {
+                bounds[0] = (float)hot.pl;
+                bounds[1] = (float)hot.pb;
+                bounds[2] = (float)hot.pr;
+                bounds[3] = (float)hot.pt;
+            } else {
+                bounds[0] = bounds[1] = HUGE_VALF;
+                bounds[2] = bounds[3] = -HUGE_VALF;
+            }
+            pair_advance[ASCII_ROW_START * 128 + c] = store.advance(GLYPH_MISSING, ascii_glyphs[c]);
+            for (uint32_t prev = 0; prev < 128; ++prev)
+                pair_advance[prev * 128 + c] = store.advance(ascii_glyphs[prev], ascii_glyphs[c]);
+        }
+    }
+
+    // every ASCII codepoint resolves to a glyph (the fallback counts)
+    bool usable() const { return complete; }
+    uint16_t glyph(uint32_t c) const { return ascii_glyphs[c]; }
+    const float* bounds(uint32_t c) const { return plane_bounds[c]; }
+    // advance of `c` after `prev`, or after ASCII_ROW_START
+    float advance(size_t prev, uint32_t c) const { return pair_advance[prev * 128 + c]; }
+
+private:
+    bool complete = false;
+    uint16_t ascii_glyphs[128] = {};
+    alignas(16) float plane_bounds[128][4] = {};
+    std::vector<float> pair_advance;
+};
+
+#endif
@@ -0,0 +1,99 @@
+#ifndef MSDF_GLYPH_TABLE_H
+#define MSDF_GLYPH_TABLE_H
+
+// Codepoint -> glyph index lookup over the full Unicode range (U+0000..U+10FFFF)
+// in O(1): a two-level page table. The high bits of the codepoint pick a page
+// from the directory, the low 8 bits pick the glyph slot inside the page.
+// Only pages that hold at least one glyph are allocated; every other directory
+// entry points at the shared empty page 0, so an ASCII/Latin font costs a
+// single 8.5 KB directory plus one 512 byte page per populated 256-codepoint
+// block. A lookup is a range check and two dependent loads.
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+const uint32_t GLYPH_PAGE_BITS = 8;
+const uint32_t GLYPH_PAGE_SIZE = 1u << GLYPH_PAGE_BITS;
+const uint32_t GLYPH_MAX_CODEPOINT = 0x10FFFF;
+const uint32_t GLYPH_DIRECTORY_SIZE = (GLYPH_MAX_CODEPOINT >> GLYPH_PAGE_BITS) + 1;
+const uint16_t GLYPH_MISSING = 0xFFFF;     // glyph index for "not in the font"
+const uint32_t GLYPH_MAX_COUNT = GLYPH_MISSING;    // glyph indices 0..65534
+
+class GlyphTable
+{
+public:
+    GlyphTable() { clear(); }
+
+    // ------------------------------------------------------------------------
+    void clear()
+    {
+        directory.assign(GLYPH_DIRECTORY_SIZE, 0);
+        slots.assign(GLYPH_PAGE_SIZE, GLYPH_MISSING);       // page 0: the shared empty page
+        fallback = GLYPH_MISSING;
+        count = 0;
+    }
+    // index the glyphs of a table sorted or unsorted by codepoint; glyph i of
+    // the input is returned by lookup() as index i. Fonts are limited to
+    // GLYPH_MAX_COUNT glyphs by the uint16 slot width; the atlas compiler and
+    // AtlasFile reject larger ones, so the clamp below is only a guard.
+    // ------------------------------------------------------------------------
+    template <typename GlyphRecord>
+    void build(const GlyphRecord* glyphs, uint32_t glyphCount)
+    {
+        clear();
+        count = glyphCount < GLYPH_MAX_COUNT ? glyphCount : GLYPH_MAX_COUNT;
+        for (uint32_t i = 0; i < count; ++i) {
+            uint32_t codepoint = glyphs[i].codepoint;
+            if (codepoint > GLYPH_MAX_CODEPOINT)
+                continue;
+            uint32_t page = codepoint >> GLYPH_PAGE_BITS;
+            if (directory[page] == 0) {
+                directory[page] = (uint16_t)(slots.size() / GLYPH_PAGE_SIZE);
+                slots.resize(slots.size() + GLYPH_PAGE_SIZE, GLYPH_MISSING);
+            }
+            slots[directory[page] * GLYPH_PAGE_SIZE + (codepoint & (GLYPH_PAGE_SIZE - 1))] = (uint16_t)i;
+        }
+
+        // replacement glyph for codepoints the font does not cover
+        static const uint32_t fallbacks[] = { 0xFFFD, '?', ' ' };
+        for (uint32_t codepoint : fallbacks) {
+            uint16_t index = lookup(codepoint);
+            if (index != GLYPH_MISSING) {
+                fallback = index;
+                break;
+            }
+        }
+    }
+
+    // glyph index, or GLYPH_MISSING when the font has no glyph for the codepoint
+    // ------------------------------------------------------------------------
+    uint16_t lookup(uint32_t codepoint) const
+    {
+        if (codepoint > GLYPH_MAX_CODEPOINT)
+            return GLYPH_MISSING;
+        return slots[directory[codepoint >> GLYPH_PAGE_BITS] * GLYPH_PAGE_SIZE + (codepoint & (GLYPH_PAGE_SIZE - 1))];
+    }
+    // glyph index, or the fallback glyph (U+FFFD, '?' or space, whichever the
+    // font has first) when the codepoint is missing; GLYPH_MISSING only when
+    // the font has none of them
+    // ------------------------------------------------------------------------
+    uint16_t lookupOrFallback(uint32_t codepoint) const
+    {
+        uint16_t index = lookup(codepoint);
+        return index != GLYPH_MISSING ? index : fallback;
+    }
+
+    uint16_t fallbackIndex() const { return fallback; }
+    uint32_t glyphCount() const { return count; }
+    uint32_t pageCount() const { return (uint32_t)(slots.size() / GLYPH_PAGE_SIZE) - 1; }
+    size_t memoryBytes() const { return directory.size() * sizeof(uint16_t) + slots.size() * sizeof(uint16_t); }
+
+private:
+    std::vector<uint16_t> directory;    // codepoint >> GLYPH_PAGE_BITS -> page number
+    std::vector<uint16_t> slots;        // pages of GLYPH_PAGE_SIZE glyph indices
+    uint16_t fallback;
+    uint32_t count;
+};
+
+#endif
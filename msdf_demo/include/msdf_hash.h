@@ -0,0 +1,28 @@
+#ifndef MSDF_HASH_H
+#define MSDF_HASH_H
+
+// Content hash shared by the caches: the texel cache and block containers
+// key their images by it, the binary atlas its source JSON, the run cache
+// its strings.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// 64-bit FNV-1a over 8 byte words, then the tail bytes; only used to detect a
+// changed source file, so speed matters more than distribution
+inline uint64_t hashBytes64(const unsigned char* data, size_t size) {
+    const uint64_t prime = 0x100000001B3ull;
+    uint64_t hash = 0xCBF29CE484222325ull ^ size;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        memcpy(&word, data + i, sizeof(word));
+        hash = (hash ^ word) * prime;
+    }
+    for (; i < size; ++i)
+        hash = (hash ^ data[i]) * prime;
+    return hash;
+}
+
+#endif
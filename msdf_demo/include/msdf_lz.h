@@ -0,0 +1,174 @@
+#ifndef MSDF_LZ_H
+#define MSDF_LZ_H
+
+// Small LZ77 block codec in the LZ4 block layout, used for the texel block
+// containers. Greedy matching on a 4 byte hash, 64 KB window; decompression
+// is a tight copy loop with full bounds checks, so a corrupted block fails
+// instead of writing out of bounds.
+//
+// Block: sequences of
+//   token       literal length (high nibble) and match length - 4 (low nibble),
+//               15 meaning "more length bytes follow" (each 255 adds 255)
+//   literals
+//   offset      uint16 little endian, distance back to the match
+// The last sequence carries literals only.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+const int LZ_MIN_MATCH = 4;
+const int LZ_HASH_BITS = 14;
+const size_t LZ_MAX_OFFSET = 65535;
+const size_t LZ_LAST_LITERALS = 5;      // the tail is always literals, keeps the decoder's copies simple
+
+inline size_t lzCompressBound(size_t size) {
+    return size + size / 255 + 16;
+}
+
+inline uint32_t lzRead32(const unsigned char* p) {
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+inline unsigned char* lzWriteLength(unsigned char* out, size_t length) {
+    for (; length >= 255; length -= 255)
+        *out++ = 255;
+    *out++ = (unsigned char)length;
+    return out;
+}
+
+// compress `size` bytes into `dst` (at least lzCompressBound(size) bytes);
+// returns the compressed size
+inline size_t lzCompress(const unsigned char* src, size_t size, unsigned char* dst) {
+    std::vector<uint32_t> table((size_t)1 << LZ_HASH_BITS, 0);
+    auto hash = [](uint32_t sequence) { return (sequence * 2654435761u) >> (32 - LZ_HASH_BITS); };
+
+    unsigned char* out = dst;
+    size_t anchor = 0;
+    size_t pos = 0;
+    size_t match_limit = size > LZ_LAST_LITERALS + LZ_MIN_MATCH ? size - LZ_LAST_LITERALS - LZ_MIN_MATCH : 0;
+
+    while (pos < match_limit) {
+        uint32_t sequence = lzRead32(src + pos);
+        uint32_t h = hash(sequence);
+        size_t candidate = table[h];
+        table[h] = (uint32_t)pos;
+        if (candidate >= pos || pos - candidate > LZ_MAX_OFFSET || lzRead32(src + candidate) != sequence) {
+            ++pos;
+            continue;
+        }
+
+        // extend the match, leaving the last literals alone
+        size_t length = LZ_MIN_MATCH;
+        size_t end = size - LZ_LAST_LITERALS;
+        while (pos + length < end && src[candidate + length] == src[pos + length])
+            ++length;
+
+        size_t literals = pos - anchor;
+        size_t match_code = length - LZ_MIN_MATCH;
+        unsigned char* token = out++;
+        *token = (unsigned char)(((literals < 15 ? literals : 15) << 4) | (match_code < 15 ? match_code : 15));
+        if (literals >= 15)
+            out = lzWriteLength(out, literals - 15);
+        memcpy(out, src + anchor, literals);
+        out += literals;
+        uint16_t offset = (uint16_t)(pos - candidate);
+        *out++ = (unsigned char)(offset & 0xFF);
+        *out++ = (unsigned char)(offset >> 8);
+        if (match_code >= 15)
+            out = lzWriteLength(out, match_code - 15);
+
+        pos += length;
+        anchor = pos;
+        if (pos - 2 < match_limit)
+            table[hash(lzRead32(src + pos - 2))] = (uint32_t)(pos - 2);
+    }
+
+    size_t literals = size - anchor;
+    *out++ = (unsigned char)((literals < 15 ? literals : 15) << 4);
+    if (literals >= 15)
+        out = lzWriteLength(out, literals - 15);
+    memcpy(out, src + anchor, literals);
+    out += literals;
+    return (size_t)(out - dst);
+}
+
+// decompress a block into exactly `size` bytes; false on corrupted input
+inline bool lzDecompress(const unsigned char* src, size_t srcSize, unsigned char* dst, size_t size) {
+    const unsigned char* in = src;
+    const unsigned char* in_end = src + srcSize;
+    unsigned char* out = dst;
+    unsigned char* out_end = dst + size;
+
+    auto readLength = [&](size_t& length) {
+        unsigned char byte;
+        do {
+            if (in >= in_end)
+                return false;
+            byte = *in++;
+            length += byte;
+        } while (byte == 255);
+        return true;
+    };
+
+    while (in < in_end) {
+        unsigned char token = *in++;
+        size_t literals = token >> 4;
+        if (literals == 15 && !readLength(literals))
+            return false;
+        if ((size_t)(in_end - in) < literals || (size_t)(out_end - out) < literals)
+            return false;
+        if (literals <= 16 && in_end - in >= 16 && out_end - out >= 16)
+            memcpy(out, in, 16);    // fixed size copy; the extra bytes are overwritten next
+        else
+            memcpy(out, in, literals);
+        in += literals;
+        out += literals;
+        if (in == in_end)
+            break;      // last sequence
+
+        if (in_end - in < 2)
+            return false;
+        size_t offset = in[0] | ((size_t)in[1] << 8);
+        in += 2;
+        size_t length = token & 15;
+        if (length == 15 && !readLength(length))
+            return false;
+        length += LZ_MIN_MATCH;
+        if (offset == 0 || offset > (size_t)(out - dst) || (size_t)(out_end - out) < length)
+            return false;
+
+        const unsigned char* match = out - offset;
+        if (offset >= 8) {
+            // the source stays at least 8 bytes behind, so every 8 byte step
+            // reads finished output; with room to spare the last step may
+            // run past the match, those bytes are overwritten next
+            unsigned char* copy_end = out + length;
+            if (out_end - copy_end >= 8) {
+                do {
+                    memcpy(out, match, 8);
+                    out += 8;
+                    match += 8;
+                } while (out < copy_end);
+                out = copy_end;
+            } else {
+                while (out + 8 <= copy_end) {
+                    memcpy(out, match, 8);
+                    out += 8;
+                    match += 8;
+                }
+                while (out < copy_end)
+                    *out++ = *match++;
+            }
+        } else {
+            for (size_t i = 0; i < length; ++i)
+                *out++ = *match++;
+        }
+    }
+    return out == out_end;
+}
+
+#endif
@@ -0,0 +1,382 @@
+#ifndef MSDF_PARAGRAPH_H
+#define MSDF_PARAGRAPH_H
+
+// Multi-line paragraph layout. Text is split into paragraphs at '\n'; each
+// paragraph is broken into lines no wider than the layout width, aligned,
+// and advanced by the font's line height in one linear pass:
+//
+//   - glyphs of the current line are resolved (glyph, pen x) into a pending
+//     buffer, the last break opportunity (after a space, around CJK
+//     ideographs) is remembered
+//   - when a glyph's advance passes the width, the pending glyphs up to the
+//     break become a line; the ones after it are rebased to the next line.
+//     A word wider than the line breaks before the overflowing glyph
+//   - a finished line is offset for its alignment and its quads are built in
+//     one batch, so no vertex is ever moved after it is written
+//
+// Positions are paragraph-local with the top of the first line at y = 0 and
+// y growing up (the demo's projection), so baselines are negative; emit()
+// stacks the paragraphs under an origin.
+//
+// Each paragraph keeps its own quads. setText() keeps the paragraphs that did
+// not change, setWidth() re-aligns single-line paragraphs that still fit
+// without laying them out again; update() reflows only what is left dirty.
+
+#include <msdf_atlas_pages.h>
+#include <msdf_font.h>
+#include <msdf_glyph_store.h>
+#include <msdf_run_cache.h>
+#include <msdf_text_layout.h>
+#include <msdf_utf8.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+enum ParagraphAlign {
+    PARAGRAPH_ALIGN_LEFT,
+    PARAGRAPH_ALIGN_CENTER,
+    PARAGRAPH_ALIGN_RIGHT
+};
+
+struct ParagraphLine {
+    float baseline;             // paragraph-local
+    float width;                // pen advance to the end of the last non-blank glyph
+    float offset;               // alignment shift applied to the line's quads
+    uint32_t first;             // first vertex in the paragraph's run
+    uint32_t count;             // vertices
+    uint32_t text_begin;        // byte range of the line in the paragraph text
+    uint32_t text_end;
+};
+
+struct Paragraph {
+    std::string text;
+    GlyphRun run;               // paragraph-local quads, ranges relative to the run
+    std::vector<ParagraphLine> lines;
+    float height = 0.0f;
+    bool dirty = true;
+};
+
+inline bool paragraphBlank(uint32_t codepoint) {
+    return codepoint == ' ' || codepoint == '\t' || codepoint == 0x3000;
+}
+
+// a break may go before `codepoint` when it follows `previous`
+inline bool paragraphBreakBefore(uint32_t previous, uint32_t codepoint) {
+    auto ideograph = [](uint32_t c) { return (c >= 0x2E80 && c <= 0x9FFF) || (c >= 0xF900 && c <= 0xFAFF) || (c >= 0x20000 && c <= 0x3FFFF); };
+    if (paragraphBlank(codepoint))
+        return false;       // blanks stay at the end of the line they follow
+    return paragraphBlank(previous) || ideograph(previous) || ideograph(codepoint);
+}
+
+class ParagraphLayout
+{
+public:
+    // width <= 0: no wrapping, lines end at '\n' only
+    ParagraphLayout(const Font& font, float scale, float width = 0.0f, ParagraphAlign align = PARAGRAPH_ALIGN_LEFT)
+        : font(font), scale(scale), layout_width(width), align(align) {}
+
+    // replace the text; paragraphs equal to the current ones at the start and
+    // the end are kept, only the ones in between are laid out again
+    // ------------------------------------------------------------------------
+    void setText(std::string_view text)
+    {
+        std::vector<std::string_view> split;
+        size_t begin = 0;
+        for (;;) {
+            size_t end = text.find('\n', begin);
+            split.push_back(text.substr(begin, end == std::string_view::npos ? std::string_view::npos : end - begin));
+            if (end == std::string_view::npos)
+                break;
+            begin = end + 1;
+        }
+
+        size_t prefix = 0;
+        while (prefix < split.size() && prefix < paragraphs.size() && paragraphs[prefix].text == split[prefix])
+            ++prefix;
+        size_t suffix = 0;
+        while (suffix < split.size() - prefix && suffix < paragraphs.size() - prefix &&
+               paragraphs[paragraphs.size() - 1 - suffix].text == split[split.size() - 1 - suffix])
+            ++suffix;
+
+        std::vector<Paragraph> changed(split.size() - prefix - suffix);
+        for (size_t i = 0; i < changed.size(); ++i)
+            changed[i].text = split[prefix + i];
+        paragraphs.erase(paragraphs.begin() + prefix, paragraphs.end() - suffix);
+        paragraphs.insert(paragraphs.begin() + prefix, std::make_move_iterator(changed.begin()), std::make_move_iterator(changed.end()));
+    }
+    // replace one paragraph (no '\n' in `text`)
+    // ------------------------------------------------------------------------
+    void setParagraph(size_t index, std::string_view text)
+    {
+        if (index >= paragraphs.size())
+            paragraphs.resize(index + 1);
+        if (paragraphs[index].text != text) {
+            paragraphs[index].text = text;
+            paragraphs[index].dirty = true;
+        }
+    }
+    // a paragraph laid out on one line that still fits is only re-aligned;
+    // everything else is marked for reflow
+    // ------------------------------------------------------------------------
+    void setWidth(float width)
+    {
+        if (width == layout_width)
+            return;
+        layout_width = width;
+        for (Paragraph& paragraph : paragraphs) {
+            if (paragraph.dirty)
+                continue;
+            if (paragraph.lines.size() == 1 && (width <= 0.0f || paragraph.lines[0].width <= width))
+                realign(paragraph);
+            else
+                paragraph.dirty = true;
+        }
+    }
+    // ------------------------------------------------------------------------
+    void setAlign(ParagraphAlign newAlign)
+    {
+        if (newAlign == align)
+            return;
+        align = newAlign;
+        for (Paragraph& paragraph : paragraphs)
+            if (!paragraph.dirty)
+                realign(paragraph);
+    }
+
+    // lay out the dirty paragraphs; returns how many were laid out
+    // ------------------------------------------------------------------------
+    size_t update()
+    {
+        size_t reflowed = 0;
+        for (Paragraph& paragraph : paragraphs)
+            if (paragraph.dirty) {
+                layoutParagraph(paragraph);
+                ++reflowed;
+            }
+        reflow_count += reflowed;
+        return reflowed;
+    }
+
+    // write the paragraphs stacked down from (x, y), the top left corner of
+    // the block, into a quad target; ranges start at target.vertices. Stops
+    // before the first paragraph that does not fit, returns the quads written
+    // ------------------------------------------------------------------------
+    size_t emit(float x, float y, LayoutTarget& target) const
+    {
+        size_t written = 0, range_count = 0;
+        for (const Paragraph& paragraph : paragraphs) {
+            LayoutTarget part(target.vertices + written * LAYOUT_QUAD_FLOATS, target.capacity - written,
+                              target.ranges ? target.ranges + range_count : nullptr,
+                              target.ranges ? target.range_capacity - range_count : 0);
+            size_t quads = GlyphRunCache::emit(paragraph.run, x, y, part);
+            if (quads == 0 && !paragraph.run.vertices.empty())
+                break;
+            for (size_t r = 0; r < part.range_count; ++r)
+                part.ranges[r].first += (uint32_t)(written * LAYOUT_QUAD_VERTICES);
+            written += quads;
+            range_count += part.range_count;
+            y -= paragraph.height;
+        }
+        target.range_count = range_count;
+        return written;
+    }
+    // append the paragraphs stacked down from (x, y) to a vertex stream; page
+    // ranges are appended with the base vertex applied
+    // ------------------------------------------------------------------------
+    void emit(float x, float y, std::vector<float>& vertices, std::vector<PageRange>* ranges = nullptr) const
+    {
+        for (const Paragraph& paragraph : paragraphs) {
+            GlyphRunCache::emit(paragraph.run, x, y, vertices, ranges);
+            y -= paragraph.height;
+        }
+    }
+    // quads and page ranges emit() writes
+    // ------------------------------------------------------------------------
+    size_t quadCount() const
+    {
+        size_t total = 0;
+        for (const Paragraph& paragraph : paragraphs)
+            total += paragraph.run.vertices.size() / LAYOUT_QUAD_FLOATS;
+        return total;
+    }
+    size_t rangeCount() const
+    {
+        size_t total = 0;
+        for (const Paragraph& paragraph : paragraphs)
+            total += paragraph.run.ranges.size();
+        return total;
+    }
+
+    size_t paragraphCount() const { return paragraphs.size(); }
+    const Paragraph& paragraph(size_t index) const { return paragraphs[index]; }
+    float width() const { return layout_width; }
+    float lineHeight() const { return font.metrics().line_height * scale; }
+    size_t reflows() const { return reflow_count; }
+
+    float height() const
+    {
+        float total = 0.0f;
+        for (const Paragraph& paragraph : paragraphs)
+            total += paragraph.height;
+        return total;
+    }
+    size_t lineCount() const
+    {
+        size_t total = 0;
+        for (const Paragraph& paragraph : paragraphs)
+            total += paragraph.lines.size();
+        return total;
+    }
+
+private:
+    const Font& font;
+    float scale;
+    float layout_width;
+    ParagraphAlign align;
+    std::vector<Paragraph> paragraphs;
+    size_t reflow_count = 0;
+
+    // pending glyphs of the line being broken, reused across paragraphs
+    std::vector<uint16_t> line_glyphs;
+    std::vector<float> line_pens;
+
+    float alignOffset(float lineWidth) const
+    {
+        if (layout_width <= 0.0f || align == PARAGRAPH_ALIGN_LEFT)
+            return 0.0f;
+        float slack = layout_width - lineWidth;
+        return align == PARAGRAPH_ALIGN_CENTER ? 0.5f * slack : slack;
+    }
+
+    // shift each line to the offset of the current width and alignment
+    void realign(Paragraph& paragraph)
+    {
+        for (ParagraphLine& line : paragraph.lines) {
+            float offset = alignOffset(line.width);
+            float shift = offset - line.offset;
+            if (shift == 0.0f)
+                continue;
+            float* vertex = paragraph.run.vertices.data() + (size_t)line.first * LAYOUT_VERTEX_FLOATS;
+            for (uint32_t v = 0; v < line.count; ++v, vertex += LAYOUT_VERTEX_FLOATS)
+                vertex[0] += shift;
+            line.offset = offset;
+        }
+    }
+
+    // build the quads of the first `count` pending glyphs as one line
+    void finishLine(Paragraph& paragraph, size_t count, float lineWidth, uint32_t textBegin, uint32_t textEnd)
+    {
+        const GlyphStore& glyphs = font.glyphs();
+        const AtlasBinHeader& metrics = font.metrics();
+        float baseline = -metrics.ascender * scale - (float)paragraph.lines.size() * metrics.line_height * scale;
+        float offset = alignOffset(lineWidth);
+
+        GlyphRun& run = paragraph.run;
+        size_t first_quad = run.vertices.size() / LAYOUT_QUAD_FLOATS;
+        run.vertices.resize((first_quad + count) * LAYOUT_QUAD_FLOATS);
+        for (size_t i = 0; i < count; ++i)
+            line_pens[i] += offset;
+        emitQuadBatch<true>(glyphs, line_glyphs.data(), line_pens.data(), count, baseline, glyphs.planeUnit() * scale,
+                            run.vertices.data() + first_quad * LAYOUT_QUAD_FLOATS);
+
+        // consecutive quads on one page share a range
+        const uint8_t* pages = glyphs.pages();
+        for (size_t i = 0; i < count; ++i) {
+            uint32_t page = pages[line_glyphs[i]];
+            uint32_t vertex = (uint32_t)((first_quad + i) * LAYOUT_QUAD_VERTICES);
+            if (!run.ranges.empty() && run.ranges.back().page == page && run.ranges.back().first + run.ranges.back().count == vertex)
+                run.ranges.back().count += (uint32_t)LAYOUT_QUAD_VERTICES;
+            else
+                run.ranges.push_back({ page, vertex, (uint32_t)LAYOUT_QUAD_VERTICES });
+        }
+
+        paragraph.lines.push_back({ baseline, lineWidth, offset, (uint32_t)(first_quad * LAYOUT_QUAD_VERTICES),
+                                    (uint32_t)(count * LAYOUT_QUAD_VERTICES), textBegin, textEnd });
+        line_glyphs.erase(line_glyphs.begin(), line_glyphs.begin() + count);
+        line_pens.erase(line_pens.begin(), line_pens.begin() + count);
+    }
+
+    void layoutParagraph(Paragraph& paragraph)
+    {
+        const GlyphStore& glyphs = font.glyphs();
+        const GlyphHot* hot = glyphs.hot();
+        paragraph.run.vertices.clear();
+        paragraph.run.vertices.reserve(paragraph.text.size() * LAYOUT_QUAD_FLOATS);   // never more glyphs than bytes
+        paragraph.run.ranges.clear();
+        paragraph.lines.clear();
+        line_glyphs.clear();
+        line_pens.clear();
+
+        const unsigned char* text = reinterpret_cast<const unsigned char*>(paragraph.text.data());
+        const unsigned char* end = text + paragraph.text.size();
+        const unsigned char* in = text;
+        float x = 0.0f;
+        float content_end = 0.0f;       // pen after the last non-blank glyph
+        uint32_t line_begin = 0;
+        uint16_t prev_glyph = GLYPH_MISSING;
+        uint32_t prev_codepoint = 0;
+
+        // the last break opportunity on the current line
+        bool can_break = false;
+        size_t break_glyphs = 0;        // pending glyphs before the break
+        float break_x = 0.0f;           // pen at the break, becomes x = 0
+        float break_width = 0.0f;
+        uint32_t break_text = 0;
+
+        while (in < end) {
+            uint32_t offset = (uint32_t)(in - text);
+            uint32_t codepoint = utf8DecodeOne(in, end);
+            uint16_t glyph = font.glyphIndex(codepoint);
+            if (glyph == GLYPH_MISSING)
+                continue;
+
+            if (content_end > 0.0f && paragraphBreakBefore(prev_codepoint, codepoint)) {
+                can_break = true;
+                break_glyphs = line_glyphs.size();
+                break_x = x;
+                break_width = content_end;
+                break_text = offset;
+            }
+
+            const GlyphHot& metrics = hot[glyph];
+            float advance = glyphs.advance(prev_glyph, glyph) * scale;
+            bool blank = paragraphBlank(codepoint);
+            if (layout_width > 0.0f && !blank && x + advance > layout_width && content_end > 0.0f) {
+                if (can_break) {
+                    finishLine(paragraph, break_glyphs, break_width, line_begin, break_text);
+                    for (float& pen : line_pens)
+                        pen -= break_x;
+                    x -= break_x;
+                    content_end = content_end > break_x ? content_end - break_x : 0.0f;
+                    line_begin = break_text;
+                } else {
+                    finishLine(paragraph, line_glyphs.size(), content_end, line_begin, offset);
+                    x = 0.0f;
+                    content_end = 0.0f;
+                    line_begin = offset;
+                    advance = metrics.advance * scale;
+                }
+                can_break = false;
+            }
+
+            if (GlyphStore::visible(metrics)) {
+                line_glyphs.push_back(glyph);
+                line_pens.push_back(x);
+            }
+            x += advance;
+            if (!blank)
+                content_end = x;
+            prev_glyph = glyph;
+            prev_codepoint = codepoint;
+        }
+        finishLine(paragraph, line_glyphs.size(), content_end, line_begin, (uint32_t)paragraph.text.size());
+
+        paragraph.height = (float)paragraph.lines.size() * font.metrics().line_height * scale;
+        paragraph.dirty = false;
+    }
+};
+
+#endif
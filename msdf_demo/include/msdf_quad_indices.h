@@ -0,0 +1,109 @@
+#ifndef MSDF_QUAD_INDICES_H
+#define MSDF_QUAD_INDICES_H
+
+// The shared static index buffer glyph quads are drawn through: quad g is
+// vertices 4g .. 4g + 3 (LAYOUT_QUAD_VERTICES corners) and indices
+// 6g .. 6g + 5 (LAYOUT_QUAD_PATTERN), so one buffer filled once serves every
+// vertex stream up to its capacity and the post-transform cache reuses the
+// two shared corners of each quad. 16-bit indices are used while the
+// capacity fits them (16384 glyphs), 32-bit ones beyond.
+//
+// PageRanges stay in vertices; draw() turns them into index ranges.
+// All calls need the GL context current and the vertex array bound: the
+// element buffer binding is vertex array state.
+
+#include <glad/gl.h>
+
+#include <msdf_atlas_pages.h>
+#include <msdf_text_layout.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+const size_t QUAD_INDICES_SHORT_GLYPHS = 65536 / LAYOUT_QUAD_VERTICES;
+
+// the indices of `glyphs` quads from quad 0
+template <typename Index>
+inline void fillQuadIndices(Index* out, size_t glyphs) {
+    for (size_t g = 0; g < glyphs; ++g)
+        for (size_t i = 0; i < LAYOUT_QUAD_INDICES; ++i)
+            out[g * LAYOUT_QUAD_INDICES + i] = (Index)(g * LAYOUT_QUAD_VERTICES + LAYOUT_QUAD_PATTERN[i]);
+}
+
+class QuadIndexBuffer
+{
+public:
+    QuadIndexBuffer() {}
+    ~QuadIndexBuffer() { release(); }
+
+    QuadIndexBuffer(const QuadIndexBuffer&) = delete;
+    QuadIndexBuffer& operator=(const QuadIndexBuffer&) = delete;
+
+    // bind to the current vertex array, with room for maxGlyphs quads
+    // ------------------------------------------------------------------------
+    void create(size_t maxGlyphs)
+    {
+        glGenBuffers(1, &ebo);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+        fill(maxGlyphs);
+    }
+    // grow (to at least double) when a stream holds more than capacity()
+    // quads; returns true when the buffer was refilled
+    // ------------------------------------------------------------------------
+    bool reserve(size_t glyphs)
+    {
+        if (glyphs <= glyph_capacity)
+            return false;
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+        fill(std::max(glyphs, glyph_capacity * 2));
+        return true;
+    }
+    void release()
+    {
+        if (ebo == 0)
+            return;
+        glDeleteBuffers(1, &ebo);
+        ebo = 0;
+        glyph_capacity = 0;
+    }
+
+    // draw the quads of a vertex range (first and count multiples of
+    // LAYOUT_QUAD_VERTICES) as triangles
+    // ------------------------------------------------------------------------
+    void draw(const PageRange& range) const
+    {
+        size_t first = range.first / LAYOUT_QUAD_VERTICES * LAYOUT_QUAD_INDICES;
+        size_t count = range.count / LAYOUT_QUAD_VERTICES * LAYOUT_QUAD_INDICES;
+        glDrawElements(GL_TRIANGLES, (GLsizei)count, index_type, (void*)(first * indexBytes()));
+    }
+
+    size_t capacity() const { return glyph_capacity; }
+    GLenum type() const { return index_type; }
+
+private:
+    GLuint ebo = 0;
+    size_t glyph_capacity = 0;
+    GLenum index_type = GL_UNSIGNED_SHORT;
+
+    size_t indexBytes() const { return index_type == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t); }
+
+    void fill(size_t glyphs)
+    {
+        glyph_capacity = glyphs;
+        if (glyphs <= QUAD_INDICES_SHORT_GLYPHS) {
+            std::vector<uint16_t> indices(glyphs * LAYOUT_QUAD_INDICES);
+            fillQuadIndices(indices.data(), glyphs);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint16_t), indices.data(), GL_STATIC_DRAW);
+            index_type = GL_UNSIGNED_SHORT;
+        } else {
+            std::vector<uint32_t> indices(glyphs * LAYOUT_QUAD_INDICES);
+            fillQuadIndices(indices.data(), glyphs);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint32_t), indices.data(), GL_STATIC_DRAW);
+            index_type = GL_UNSIGNED_INT;
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,176 @@
+#ifndef MSDF_RUN_CACHE_H
+#define MSDF_RUN_CACHE_H
+
+// Cache of laid-out glyph runs keyed by (font, text, scale). A run keeps its
+// quads in label-local coordinates (pen starting at 0, 0) grouped by atlas
+// page; drawing a cached label at any origin only translates the positions,
+// layout is skipped entirely. Entries are evicted least recently used once
+// the cached vertex and text bytes exceed the budget.
+//
+// Not thread safe: use one cache per thread (e.g. one for the render thread).
+
+#include <msdf_atlas_pages.h>
+#include <msdf_font.h>
+#include <msdf_hash.h>
+#include <msdf_text_layout.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+const size_t RUN_CACHE_DEFAULT_BUDGET = 4 * 1024 * 1024;
+
+struct GlyphRun {
+    std::vector<float> vertices;        // label-local quads
+    std::vector<PageRange> ranges;      // one per referenced page, relative to the run
+
+    size_t bytes() const { return vertices.capacity() * sizeof(float) + ranges.capacity() * sizeof(PageRange); }
+};
+
+class GlyphRunCache
+{
+public:
+    explicit GlyphRunCache(size_t budgetBytes = RUN_CACHE_DEFAULT_BUDGET) : budget_bytes(budgetBytes) {}
+
+    GlyphRunCache(const GlyphRunCache&) = delete;
+    GlyphRunCache& operator=(const GlyphRunCache&) = delete;
+
+    // the run of `text` in `font` at `scale`; on a miss layout(run) fills an
+    // empty run with label-local quads. The reference stays valid until the
+    // next call to run() or clear(). A hit does not allocate
+    // ------------------------------------------------------------------------
+    template <typename Layout>
+    const GlyphRun& run(FontId font, const std::string& text, float scale, Layout layout)
+    {
+        uint64_t key = hashKey(font, text, scale);
+        auto found = index.find(key);
+        if (found != index.end()) {
+            Entry& entry = *found->second;
+            if (entry.font == font && entry.scale == scale && entry.text == text) {
+                ++hit_count;
+                lru.splice(lru.begin(), lru, found->second);
+                return entry.run;
+            }
+            // 64-bit key collision: replace the older entry
+            erase(found->second);
+        }
+
+        ++miss_count;
+        lru.emplace_front();
+        Entry& entry = lru.front();
+        entry.key = key;
+        entry.font = font;
+        entry.scale = scale;
+        entry.text = text;
+        layout(entry.run);
+        entry.bytes = entry.run.bytes() + entry.text.capacity() + sizeof(Entry);
+        index[key] = lru.begin();
+        cached_bytes += entry.bytes;
+
+        // evict from the cold end, never the run just made
+        while (cached_bytes > budget_bytes && lru.size() > 1) {
+            erase(std::prev(lru.end()));
+            ++eviction_count;
+        }
+        return entry.run;
+    }
+
+    // write a run placed at origin (x, y) into a quad target, e.g. a mapped
+    // stream region, translating the positions on the way (the target is only
+    // written, never read back); its ranges start at target.vertices. Returns
+    // the quads written: all of the run, or 0 when it or its ranges do not fit
+    // ------------------------------------------------------------------------
+    static size_t emit(const GlyphRun& run, float x, float y, LayoutTarget& target)
+    {
+        target.range_count = 0;
+        size_t quads = run.vertices.size() / LAYOUT_QUAD_FLOATS;
+        if (quads > target.capacity || (target.ranges && run.ranges.size() > target.range_capacity))
+            return 0;
+        const float* source = run.vertices.data();
+        float* out = target.vertices;
+        for (size_t v = 0; v < run.vertices.size(); v += LAYOUT_VERTEX_FLOATS) {
+            out[v + 0] = source[v + 0] + x;
+            out[v + 1] = source[v + 1] + y;
+            memcpy(out + v + 2, source + v + 2, (LAYOUT_VERTEX_FLOATS - 2) * sizeof(float));
+        }
+        if (target.ranges) {
+            std::copy(run.ranges.begin(), run.ranges.end(), target.ranges);
+            target.range_count = run.ranges.size();
+        }
+        return quads;
+    }
+    // append a run placed at origin (x, y) to a vertex stream; its page ranges
+    // are appended with the base vertex applied
+    // ------------------------------------------------------------------------
+    static void emit(const GlyphRun& run, float x, float y, std::vector<float>& vertices, std::vector<PageRange>* ranges = nullptr)
+    {
+        uint32_t base = (uint32_t)(vertices.size() / LAYOUT_VERTEX_FLOATS);
+        size_t first = vertices.size();
+        size_t first_range = ranges ? ranges->size() : 0;
+        vertices.resize(first + run.vertices.size());
+        if (ranges)
+            ranges->resize(first_range + run.ranges.size());
+        LayoutTarget target(vertices.data() + first, run.vertices.size() / LAYOUT_QUAD_FLOATS,
+                            ranges ? ranges->data() + first_range : nullptr, run.ranges.size());
+        emit(run, x, y, target);
+        if (ranges)
+            for (size_t r = first_range; r < ranges->size(); ++r)
+                (*ranges)[r].first += base;
+    }
+
+    // ------------------------------------------------------------------------
+    void clear()
+    {
+        lru.clear();
+        index.clear();
+        cached_bytes = 0;
+    }
+    void setBudget(size_t budgetBytes) { budget_bytes = budgetBytes; }
+
+    uint64_t hits() const { return hit_count; }
+    uint64_t misses() const { return miss_count; }
+    uint64_t evictions() const { return eviction_count; }
+    size_t bytes() const { return cached_bytes; }
+    size_t budget() const { return budget_bytes; }
+    size_t entryCount() const { return lru.size(); }
+
+private:
+    struct Entry {
+        uint64_t key;
+        FontId font;
+        float scale;
+        std::string text;
+        GlyphRun run;
+        size_t bytes;
+    };
+
+    size_t budget_bytes;
+    size_t cached_bytes = 0;
+    uint64_t hit_count = 0;
+    uint64_t miss_count = 0;
+    uint64_t eviction_count = 0;
+    std::list<Entry> lru;                                           // most recently used first
+    std::unordered_map<uint64_t, std::list<Entry>::iterator> index;
+
+    static uint64_t hashKey(FontId font, const std::string& text, float scale)
+    {
+        uint32_t scale_bits;
+        memcpy(&scale_bits, &scale, sizeof(scale_bits));
+        uint64_t key = hashBytes64(reinterpret_cast<const unsigned char*>(text.data()), text.size());
+        key ^= ((uint64_t)font << 32 | scale_bits) * 0x9E3779B97F4A7C15ull;
+        return key;
+    }
+    void erase(std::list<Entry>::iterator it)
+    {
+        cached_bytes -= it->bytes;
+        index.erase(it->key);
+        lru.erase(it);
+    }
+};
+
+#endif
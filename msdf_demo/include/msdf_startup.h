@@ -0,0 +1,102 @@
+#ifndef MSDF_STARTUP_H
+#define MSDF_STARTUP_H
+
+// Helpers for the parallel startup pipeline: the CPU-only stages (atlas
+// load, texel load/decode, shader source reads) run on worker threads while the
+// main thread creates the window and GL context; their results are handed
+// to the GL thread for compile/upload. StartupTimeline records when every
+// stage ran on which thread and prints the timeline up to the first frame.
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class StartupTimeline
+{
+public:
+    StartupTimeline() : origin(std::chrono::steady_clock::now()) {}
+
+    // run fn() as the named stage on the calling thread and record it
+    // ------------------------------------------------------------------------
+    template <typename Fn>
+    auto run(const char* stage, Fn fn) -> decltype(fn())
+    {
+        Scope scope(*this, stage);
+        return fn();
+    }
+    // record a point event (e.g. "first frame")
+    // ------------------------------------------------------------------------
+    void mark(const char* event)
+    {
+        double t = elapsedMs();
+        record(event, t, t);
+    }
+    // ------------------------------------------------------------------------
+    void print() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<Entry> sorted = entries;
+        std::sort(sorted.begin(), sorted.end(), [](const Entry& a, const Entry& b) { return a.start < b.start; });
+
+        double total = 0.0;
+        for (const Entry& entry : sorted)
+            total = std::max(total, entry.end);
+        const int width = 40;
+
+        std::cout << "startup timeline (ms)" << std::endl;
+        for (const Entry& entry : sorted) {
+            int from = total > 0.0 ? (int)(entry.start / total * width) : 0;
+            int to = total > 0.0 ? (int)(entry.end / total * width) : 0;
+            std::string bar(width + 1, ' ');
+            for (int i = from; i <= to && i <= width; ++i)
+                bar[i] = (entry.start == entry.end) ? '|' : '#';
+            std::string thread = entry.thread == 0 ? "main" : "worker " + std::to_string(entry.thread);
+            std::cout << "  " << std::left << std::setw(18) << entry.name << std::setw(10) << thread
+                      << std::right << std::fixed << std::setprecision(2) << std::setw(9) << entry.start
+                      << std::setw(9) << entry.end << "  [" << bar << "]" << std::endl;
+        }
+    }
+
+private:
+    struct Entry {
+        std::string name;
+        int thread;         // 0 is the thread that created the timeline
+        double start;
+        double end;
+    };
+    struct Scope {
+        Scope(StartupTimeline& timeline, const char* stage) : timeline(timeline), stage(stage), start(timeline.elapsedMs()) {}
+        ~Scope() { timeline.record(stage, start, timeline.elapsedMs()); }
+        StartupTimeline& timeline;
+        const char* stage;
+        double start;
+    };
+
+    std::chrono::steady_clock::time_point origin;
+    mutable std::mutex mutex;
+    std::vector<Entry> entries;
+    std::vector<std::thread::id> threads{ std::this_thread::get_id() };
+
+    double elapsedMs() const
+    {
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - origin;
+        return elapsed.count();
+    }
+    void record(const char* name, double start, double end)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::thread::id id = std::this_thread::get_id();
+        auto it = std::find(threads.begin(), threads.end(), id);
+        int thread = (int)(it - threads.begin());
+        if (it == threads.end())
+            threads.push_back(id);
+        entries.push_back({ name, thread, start, end });
+    }
+};
+
+#endif
@@ -0,0 +1,242 @@
+#ifndef MSDF_STREAM_BUFFER_H
+#define MSDF_STREAM_BUFFER_H
+
+// Streaming vertex allocator for text that changes every frame (clocks,
+// speeds, counters). One GL_ARRAY_BUFFER is split into STREAM_FRAMES
+// regions: the CPU writes this frame's region while the GPU still reads the
+// previous ones, and a fence sync placed after each frame's draws tells when
+// a region may be written again. Labels are laid out straight into the
+// returned spans (a LayoutTarget over StreamSpan::data), with no staging
+// copy and no glBufferData per frame.
+//
+// With GL 4.4 or ARB_buffer_storage the buffer has immutable storage mapped
+// once, persistent and coherent; writing a region whose fence has not
+// signaled yet waits on it (counted in waits()). Otherwise (glad loads
+// GL 3.3 only, so glBufferStorage is fetched through the loader passed to
+// create()) each frame maps its region with glMapBufferRange, unsynchronized
+// and flushed explicitly, and a region still in flight is not waited for:
+// the whole buffer is orphaned instead (counted in orphans()). A persistent
+// mapping that fails falls back to the per-frame one.
+//
+// Per frame: beginFrame(), allocate() and write, flush() before the draws
+// that read the spans, endFrame() after them. beginFrame(bytes) grows the
+// regions when a frame needs more; the buffer name then changes, so vertex
+// attributes are pointed at bufferId() every frame.
+// All calls need the GL context current; they bind GL_ARRAY_BUFFER.
+
+#include <glad/gl.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+// GL 4.4 tokens, absent from a GL 3.3 loader
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+
+const size_t STREAM_FRAMES = 3;         // regions: one written, up to two read by the GPU
+const size_t STREAM_ALIGN = 256;        // region size granularity; spans align to at most this
+
+// a slice of the current frame's region; data is null when the region is full
+struct StreamSpan {
+    void* data = nullptr;
+    size_t offset = 0;                  // bytes from the start of bufferId(), for attribute pointers
+};
+
+class StreamBuffer
+{
+public:
+    typedef void (GLAD_API_PTR* BufferStorageProc)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+
+    StreamBuffer() {}
+    ~StreamBuffer() { release(); }
+
+    StreamBuffer(const StreamBuffer&) = delete;
+    StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+    // regions of frameBytes; loader (glfwGetProcAddress) looks up
+    // glBufferStorage, without it the unsynchronized mapping is used
+    // ------------------------------------------------------------------------
+    bool create(size_t frameBytes, GLADloadfunc loader = nullptr)
+    {
+        buffer_storage = nullptr;
+        if (loader && hasBufferStorage())
+            buffer_storage = reinterpret_cast<BufferStorageProc>(loader("glBufferStorage"));
+        return allocateStorage(frameBytes);
+    }
+    // ------------------------------------------------------------------------
+    void release()
+    {
+        if (buffer == 0)
+            return;
+        deleteFences();
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        if (mapped || frame_data)
+            glUnmapBuffer(GL_ARRAY_BUFFER);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glDeleteBuffers(1, &buffer);
+        buffer = 0;
+        mapped = nullptr;
+        frame_data = nullptr;
+    }
+
+    // make the next region writable, grown to at least `bytes` first
+    // ------------------------------------------------------------------------
+    bool beginFrame(size_t bytes = 0)
+    {
+        if (bytes > region_bytes && !allocateStorage(std::max(bytes, region_bytes * 2)))
+            return false;
+        used_bytes = 0;
+        GLsync& fence = fences[region];
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        if (buffer_storage) {
+            if (fence) {
+                waitFence(fence);
+                glDeleteSync(fence);
+                fence = nullptr;
+            }
+            frame_data = static_cast<unsigned char*>(mapped) + frameOffset();
+            return true;
+        }
+        if (fence && glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+            // the GPU still reads this region: new storage instead of a stall
+            glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(region_bytes * STREAM_FRAMES), nullptr, GL_STREAM_DRAW);
+            deleteFences();
+            ++orphan_count;
+        } else if (fence) {
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+        frame_data = static_cast<unsigned char*>(glMapBufferRange(GL_ARRAY_BUFFER, (GLintptr)frameOffset(), (GLsizeiptr)region_bytes,
+            GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_FLUSH_EXPLICIT_BIT));
+        if (frame_data == nullptr) {
+            std::cout << "ERROR::STREAM_BUFFER::MAP_FAILED: " << region_bytes << " bytes" << std::endl;
+            return false;
+        }
+        return true;
+    }
+    // `bytes` from this frame's region, `align` a power of two up to STREAM_ALIGN
+    // ------------------------------------------------------------------------
+    StreamSpan allocate(size_t bytes, size_t align = 16)
+    {
+        StreamSpan span;
+        size_t start = (used_bytes + align - 1) & ~(align - 1);
+        if (frame_data == nullptr || start + bytes > region_bytes)
+            return span;
+        used_bytes = start + bytes;
+        span.data = frame_data + start;
+        span.offset = frameOffset() + start;
+        return span;
+    }
+    // the frame's writes reach the GPU; call before drawing from its spans
+    // ------------------------------------------------------------------------
+    void flush()
+    {
+        if (buffer_storage || frame_data == nullptr)
+            return;
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        if (used_bytes)
+            glFlushMappedBufferRange(GL_ARRAY_BUFFER, 0, (GLsizeiptr)used_bytes);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+        frame_data = nullptr;
+    }
+    // fence the region after the draws that read it, move to the next one
+    // ------------------------------------------------------------------------
+    void endFrame()
+    {
+        flush();
+        frame_data = nullptr;
+        fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        region = (region + 1) % STREAM_FRAMES;
+    }
+
+    GLuint bufferId() const { return buffer; }
+    bool persistent() const { return buffer_storage != nullptr; }
+    size_t regionBytes() const { return region_bytes; }
+    size_t frameOffset() const { return region * region_bytes; }
+    size_t used() const { return used_bytes; }
+    size_t waits() const { return wait_count; }
+    size_t orphans() const { return orphan_count; }
+
+private:
+    GLuint buffer = 0;
+    BufferStorageProc buffer_storage = nullptr;
+    void* mapped = nullptr;             // the whole buffer, persistent mode only
+    unsigned char* frame_data = nullptr;    // the current region while it is writable
+    size_t region_bytes = 0;
+    size_t region = 0;
+    size_t used_bytes = 0;
+    GLsync fences[STREAM_FRAMES] = {};
+    size_t wait_count = 0;
+    size_t orphan_count = 0;
+
+    static bool hasBufferStorage()
+    {
+        GLint major = 0, minor = 0, extensions = 0;
+        glGetIntegerv(GL_MAJOR_VERSION, &major);
+        glGetIntegerv(GL_MINOR_VERSION, &minor);
+        if (major > 4 || (major == 4 && minor >= 4))
+            return true;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &extensions);
+        for (GLint i = 0; i < extensions; ++i) {
+            const char* name = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, (GLuint)i));
+            if (name && strcmp(name, "GL_ARB_buffer_storage") == 0)
+                return true;
+        }
+        return false;
+    }
+
+    bool allocateStorage(size_t frameBytes)
+    {
+        release();
+        region_bytes = (frameBytes + STREAM_ALIGN - 1) / STREAM_ALIGN * STREAM_ALIGN;
+        region = 0;
+        const GLsizeiptr total = (GLsizeiptr)(region_bytes * STREAM_FRAMES);
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        if (buffer_storage) {
+            const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            buffer_storage(GL_ARRAY_BUFFER, total, nullptr, flags);
+            mapped = glMapBufferRange(GL_ARRAY_BUFFER, 0, total, flags);
+            if (mapped)
+                return true;
+            // immutable storage cannot be respecified: drop it for a new
+            // buffer and the per-frame mapping
+            std::cout << "ERROR::STREAM_BUFFER::MAP_FAILED: " << total << " bytes, persistent mapping disabled" << std::endl;
+            release();
+            buffer_storage = nullptr;
+            glGenBuffers(1, &buffer);
+            glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        }
+        glBufferData(GL_ARRAY_BUFFER, total, nullptr, GL_STREAM_DRAW);
+        return true;
+    }
+
+    // a client wait that blocks counts as a stall
+    void waitFence(GLsync fence)
+    {
+        GLenum status = glClientWaitSync(fence, 0, 0);
+        if (status != GL_TIMEOUT_EXPIRED)
+            return;
+        ++wait_count;
+        while (status == GL_TIMEOUT_EXPIRED)
+            status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+    }
+
+    void deleteFences()
+    {
+        for (GLsync& fence : fences) {
+            if (fence)
+                glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+};
+
+#endif
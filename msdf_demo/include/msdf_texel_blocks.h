@@ -0,0 +1,485 @@
+#ifndef MSDF_TEXEL_BLOCKS_H
+#define MSDF_TEXEL_BLOCKS_H
+
+// Block-compressed texel containers, an optional replacement for the PNG of
+// an atlas page. The upload-ready texels (flipped for GL, file channel
+// layout) are cut into bands of rows_per_block rows, each band delta filtered
+// and LZ compressed on its own; the packer keeps whichever filter compresses
+// the band best. Bands decode independently, so a page is decompressed by
+// several threads straight into the upload buffer, and a caller that needs
+// only some rows decodes only the bands covering them.
+//
+// Size trade-off: there is no entropy stage, so a container is larger than
+// the PNG (msdf_test2: 710 KB against 436 KB) but decodes about twice as
+// fast on one thread, and in parallel across bands. The bundled atlas pages
+// ship with their containers; a page without one (or whose PNG no longer
+// matches the recorded hash) falls back to the PNG. Re-pack after changing
+// a page image or TEXEL_BLOCKS_VERSION.
+//
+// File layout: TexelBlocksHeader, TexelBlock table, compressed bands.
+// "<image>.blocks" is written offline by "msdf_demo --pack-texels <image>".
+
+#include <msdf_lz.h>
+#include <msdf_mapped_file.h>
+#include <msdf_texel_cache.h>
+#include <stb_image.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+const uint32_t TEXEL_BLOCKS_MAGIC   = 0x4244534D; // "MSDB"
+const uint32_t TEXEL_BLOCKS_VERSION = 2;
+const uint32_t TEXEL_BLOCKS_ROWS    = 32;         // default rows per band
+const uint32_t TEXEL_BLOCKS_MAX_ROWS = 0xFFFF;    // rows per band, TexelBlock::rows
+
+// per band; rows above a band read as zero, so every band decodes on its own
+enum TexelBlocksFilter {
+    TEXEL_FILTER_NONE     = 0,
+    TEXEL_FILTER_SUB      = 1,  // every byte minus the same channel of the pixel to its left
+    TEXEL_FILTER_UP       = 2,  // minus the byte above
+    TEXEL_FILTER_GRADIENT = 3,  // minus left + above - above left, clamped to 0..255
+    TEXEL_FILTER_COUNT
+};
+
+struct TexelBlocksHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t source_hash;       // hashBytes64() of the source image file
+    uint64_t source_size;
+    uint32_t width;
+    uint32_t height;
+    uint32_t channels;
+    uint32_t flipped;           // 1 when rows are stored bottom-up (GL order)
+    uint32_t rows_per_block;
+    uint32_t block_count;
+    uint32_t reserved;
+    uint32_t block_offset;      // offset of the TexelBlock table
+};
+
+struct TexelBlock {
+    uint64_t offset;            // compressed band
+    uint32_t size;              // compressed bytes
+    uint16_t rows;              // rows in the band (the last one may be short)
+    uint16_t filter;            // TexelBlocksFilter
+};
+
+static_assert(sizeof(TexelBlocksHeader) == 56, "TexelBlocksHeader layout changed");
+static_assert(sizeof(TexelBlock) == 16, "TexelBlock layout changed");
+
+inline std::string texelBlocksPath(const std::string& imagePath) {
+    return imagePath + ".blocks";
+}
+
+// decode statistics; busy time is summed over the decoding threads
+struct TexelDecodeStats {
+    size_t bytes = 0;           // decompressed texel bytes
+    size_t blocks = 0;
+    unsigned threads = 0;
+    double milliseconds = 0.0;
+    double busy_milliseconds = 0.0;
+
+    double megabytesPerSecond() const { return milliseconds > 0.0 ? bytes / (milliseconds * 1000.0) : 0.0; }
+    double megabytesPerSecondPerCore() const { return busy_milliseconds > 0.0 ? bytes / (busy_milliseconds * 1000.0) : 0.0; }
+};
+
+// run work(index) for index in [0, count) on up to `threads` threads, the
+// calling thread included; indices are handed out through an atomic counter
+template <typename Work>
+inline void texelBlocksParallel(size_t count, unsigned threads, Work work) {
+    std::atomic<size_t> next(0);
+    auto worker = [&]() {
+        for (size_t index = next++; index < count; index = next++)
+            work(index);
+    };
+    std::vector<std::thread> pool;
+    for (unsigned i = 1; i < threads && i < count; ++i)
+        pool.emplace_back(worker);
+    worker();
+    for (std::thread& thread : pool)
+        thread.join();
+}
+
+inline unsigned texelBlocksThreads(unsigned threads) {
+    if (threads == 0)
+        threads = std::thread::hardware_concurrency();
+    return threads == 0 ? 1 : threads;
+}
+
+// prediction of a byte from its left, above and above-left neighbours
+inline unsigned char texelPredict(uint32_t filter, int left, int above, int aboveLeft) {
+    switch (filter) {
+    case TEXEL_FILTER_SUB:      return (unsigned char)left;
+    case TEXEL_FILTER_UP:       return (unsigned char)above;
+    case TEXEL_FILTER_GRADIENT: return (unsigned char)std::min(std::max(left + above - aboveLeft, 0), 255);
+    default:                    return 0;
+    }
+}
+
+// pack upload-ready texels into a container image in memory; every band is
+// compressed with each filter and keeps the smallest
+// ------------------------------------------------------------------------
+inline std::vector<unsigned char> packTexelBlocks(const unsigned char* pixels, int width, int height, int channels,
+                                                  bool flipped, uint64_t sourceHash, uint64_t sourceSize,
+                                                  uint32_t rowsPerBlock = TEXEL_BLOCKS_ROWS, unsigned threads = 0) {
+    const size_t stride = (size_t)width * channels;
+    rowsPerBlock = std::min(rowsPerBlock, TEXEL_BLOCKS_MAX_ROWS);
+    const uint32_t block_count = (height + rowsPerBlock - 1) / rowsPerBlock;
+
+    std::vector<std::vector<unsigned char>> bands(block_count);
+    std::vector<uint16_t> filters(block_count);
+    texelBlocksParallel(block_count, texelBlocksThreads(threads), [&](size_t block) {
+        size_t first = block * rowsPerBlock;
+        size_t rows = std::min<size_t>(rowsPerBlock, height - first);
+        std::vector<unsigned char> filtered(rows * stride);
+        std::vector<unsigned char> compressed(lzCompressBound(filtered.size()));
+        for (uint32_t filter = 0; filter < TEXEL_FILTER_COUNT; ++filter) {
+            for (size_t row = 0; row < rows; ++row) {
+                unsigned char* line = filtered.data() + row * stride;
+                const unsigned char* source = pixels + (first + row) * stride;
+                const unsigned char* above = row > 0 ? source - stride : nullptr;
+                for (size_t i = 0; i < stride; ++i) {
+                    int left = i >= (size_t)channels ? source[i - channels] : 0;
+                    int up = above ? above[i] : 0;
+                    int up_left = above && i >= (size_t)channels ? above[i - channels] : 0;
+                    line[i] = (unsigned char)(source[i] - texelPredict(filter, left, up, up_left));
+                }
+            }
+            size_t size = lzCompress(filtered.data(), filtered.size(), compressed.data());
+            if (filter == 0 || size < bands[block].size()) {
+                bands[block].assign(compressed.begin(), compressed.begin() + size);
+                filters[block] = (uint16_t)filter;
+            }
+        }
+    });
+
+    TexelBlocksHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = TEXEL_BLOCKS_MAGIC;
+    header.version = TEXEL_BLOCKS_VERSION;
+    header.source_hash = sourceHash;
+    header.source_size = sourceSize;
+    header.width = (uint32_t)width;
+    header.height = (uint32_t)height;
+    header.channels = (uint32_t)channels;
+    header.flipped = flipped ? 1 : 0;
+    header.rows_per_block = rowsPerBlock;
+    header.block_count = block_count;
+    header.block_offset = sizeof(TexelBlocksHeader);
+
+    std::vector<TexelBlock> table(block_count);
+    uint64_t offset = header.block_offset + block_count * sizeof(TexelBlock);
+    for (uint32_t i = 0; i < block_count; ++i) {
+        table[i].offset = offset;
+        table[i].size = (uint32_t)bands[i].size();
+        table[i].rows = (uint16_t)std::min<uint32_t>(rowsPerBlock, height - i * rowsPerBlock);
+        table[i].filter = filters[i];
+        offset += bands[i].size();
+    }
+
+    std::vector<unsigned char> file(offset);
+    memcpy(file.data(), &header, sizeof(header));
+    memcpy(file.data() + header.block_offset, table.data(), table.size() * sizeof(TexelBlock));
+    for (uint32_t i = 0; i < block_count; ++i)
+        memcpy(file.data() + table[i].offset, bands[i].data(), bands[i].size());
+    return file;
+}
+
+// decode a PNG (or any stb_image format) and write its container to `outPath`
+// ------------------------------------------------------------------------
+inline bool packTexelBlocksFile(const std::string& imagePath, const std::string& outPath, bool flipVertically = true) {
+    MappedFile source;
+    if (!source.open(imagePath)) {
+        std::cout << "ERROR::TEXELS::FILE_NOT_SUCCESSFULLY_READ: " << imagePath << std::endl;
+        return false;
+    }
+    int width, height, channels;
+    stbi_set_flip_vertically_on_load_thread(flipVertically ? 1 : 0);
+    unsigned char* pixels = stbi_load_from_memory(source.data(), (int)source.size(), &width, &height, &channels, 0);
+    if (pixels == nullptr) {
+        std::cout << "ERROR::TEXELS::DECODE_FAILED: " << imagePath << " " << stbi_failure_reason() << std::endl;
+        return false;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<unsigned char> file = packTexelBlocks(pixels, width, height, channels, flipVertically,
+                                                      hashBytes64(source.data(), source.size()), source.size());
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    size_t raw = (size_t)width * height * channels;
+    stbi_image_free(pixels);
+
+    std::ofstream outputFile(outPath, std::ios::binary | std::ios::trunc);
+    outputFile.write(reinterpret_cast<const char*>(file.data()), file.size());
+    if (!outputFile.good()) {
+        std::cout << "ERROR::TEXELS::BLOCKS_NOT_WRITTEN: " << outPath << std::endl;
+        return false;
+    }
+    std::cout << "TEXELS::PACK: " << imagePath << " -> " << outPath << " " << raw << " -> " << file.size()
+              << " bytes (png " << source.size() << ") in " << elapsed.count() << " ms" << std::endl;
+    return true;
+}
+
+class TexelBlockFile
+{
+public:
+    TexelBlockFile() {}
+
+    TexelBlockFile(const TexelBlockFile&) = delete;
+    TexelBlockFile& operator=(const TexelBlockFile&) = delete;
+
+    // map a container file; false when it is missing or invalid
+    // ------------------------------------------------------------------------
+    bool open(const std::string& path)
+    {
+        close();
+        if (!file.open(path))
+            return false;
+        if (!view(file.data(), file.size())) {
+            std::cout << "ERROR::TEXELS::INVALID_BLOCKS: " << path << std::endl;
+            close();
+            return false;
+        }
+        return true;
+    }
+    // use a container already in memory (kept alive by the caller)
+    // ------------------------------------------------------------------------
+    bool view(const unsigned char* bytes, size_t length)
+    {
+        data = bytes;
+        size = length;
+        if (!validate()) {
+            data = nullptr;
+            size = 0;
+            return false;
+        }
+        return true;
+    }
+    // ------------------------------------------------------------------------
+    void close()
+    {
+        file.close();
+        data = nullptr;
+        size = 0;
+    }
+
+    bool isOpen() const { return data != nullptr; }
+    const TexelBlocksHeader& header() const { return *reinterpret_cast<const TexelBlocksHeader*>(data); }
+    const TexelBlock* blocks() const { return reinterpret_cast<const TexelBlock*>(data + header().block_offset); }
+    size_t rowStride() const { return (size_t)header().width * header().channels; }
+    size_t imageBytes() const { return rowStride() * header().height; }
+
+    // decode the bands covering rows [firstRow, firstRow + rowCount) into
+    // `image`, a buffer of imageBytes() laid out like the full image; rows of
+    // other bands are left untouched. Returns false on a corrupted band
+    // ------------------------------------------------------------------------
+    bool decodeRows(uint32_t firstRow, uint32_t rowCount, unsigned char* image, unsigned threads = 0,
+                    TexelDecodeStats* stats = nullptr) const
+    {
+        const TexelBlocksHeader& h = header();
+        if (rowCount == 0 || firstRow >= h.height)
+            return true;
+        uint32_t first_block = firstRow / h.rows_per_block;
+        uint32_t last_block = std::min(h.height - 1, firstRow + rowCount - 1) / h.rows_per_block;
+        uint32_t count = last_block - first_block + 1;
+        threads = std::min(texelBlocksThreads(threads), count);
+
+        const size_t stride = rowStride();
+        const size_t channels = h.channels;
+        std::atomic<bool> ok(true);
+        std::vector<double> busy(count, 0.0);
+
+        auto start = std::chrono::steady_clock::now();
+        texelBlocksParallel(count, threads, [&](size_t index) {
+            auto block_start = std::chrono::steady_clock::now();
+            uint32_t block = first_block + (uint32_t)index;
+            const TexelBlock& entry = blocks()[block];
+            unsigned char* band = image + (size_t)block * h.rows_per_block * stride;
+            if (!lzDecompress(data + entry.offset, entry.size, band, entry.rows * stride)) {
+                ok = false;
+                return;
+            }
+            for (uint32_t row = 0; row < entry.rows; ++row) {
+                unsigned char* line = band + row * stride;
+                if (entry.filter == TEXEL_FILTER_SUB || (entry.filter == TEXEL_FILTER_GRADIENT && row == 0))
+                    unfilterSub(line, h.width, channels);
+                else if (entry.filter == TEXEL_FILTER_UP && row > 0)
+                    unfilterUp(line, line - stride, stride);
+                else if (entry.filter == TEXEL_FILTER_GRADIENT)
+                    unfilterGradient(line, line - stride, stride, channels);
+            }
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - block_start;
+            busy[index] = elapsed.count();
+        });
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+        if (stats) {
+            stats->bytes = 0;
+            for (uint32_t block = first_block; block <= last_block; ++block)
+                stats->bytes += blocks()[block].rows * stride;
+            stats->blocks = count;
+            stats->threads = threads;
+            stats->milliseconds = elapsed.count();
+            stats->busy_milliseconds = 0.0;
+            for (double ms : busy)
+                stats->busy_milliseconds += ms;
+        }
+        return ok;
+    }
+
+private:
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+    MappedFile file;
+
+    // undo TEXEL_FILTER_SUB for one row; the running value of every channel
+    // stays in a register instead of being reloaded from the previous pixel
+    // ------------------------------------------------------------------------
+    static void unfilterSub(unsigned char* line, uint32_t width, size_t channels)
+    {
+        unsigned char sum[4] = { 0, 0, 0, 0 };
+        switch (channels) {
+        case 3:
+            for (uint32_t x = 0; x < width; ++x, line += 3) {
+                line[0] = sum[0] = (unsigned char)(sum[0] + line[0]);
+                line[1] = sum[1] = (unsigned char)(sum[1] + line[1]);
+                line[2] = sum[2] = (unsigned char)(sum[2] + line[2]);
+            }
+            break;
+        case 4:
+            for (uint32_t x = 0; x < width; ++x, line += 4) {
+                line[0] = sum[0] = (unsigned char)(sum[0] + line[0]);
+                line[1] = sum[1] = (unsigned char)(sum[1] + line[1]);
+                line[2] = sum[2] = (unsigned char)(sum[2] + line[2]);
+                line[3] = sum[3] = (unsigned char)(sum[3] + line[3]);
+            }
+            break;
+        default:
+            for (size_t i = 0; i < width * channels; ++i)
+                line[i] = sum[i % channels] = (unsigned char)(sum[i % channels] + line[i]);
+            break;
+        }
+    }
+    // undo TEXEL_FILTER_UP for one row below the first of its band
+    // ------------------------------------------------------------------------
+    static void unfilterUp(unsigned char* line, const unsigned char* above, size_t stride)
+    {
+        for (size_t i = 0; i < stride; ++i)
+            line[i] = (unsigned char)(line[i] + above[i]);
+    }
+    // undo TEXEL_FILTER_GRADIENT for one row below the first of its band; the
+    // first pixel has no left neighbour and predicts from above alone
+    // ------------------------------------------------------------------------
+    static void unfilterGradient(unsigned char* line, const unsigned char* above, size_t stride, size_t channels)
+    {
+        switch (channels) {
+        case 3:
+            unfilterGradientPixels<3>(line, above, stride / 3);
+            break;
+        case 4:
+            unfilterGradientPixels<4>(line, above, stride / 4);
+            break;
+        default:
+            for (size_t i = 0; i < channels; ++i)
+                line[i] = (unsigned char)(line[i] + above[i]);
+            for (size_t i = channels; i < stride; ++i)
+                line[i] = (unsigned char)(line[i] + texelPredict(TEXEL_FILTER_GRADIENT, line[i - channels], above[i], above[i - channels]));
+            break;
+        }
+    }
+    // the left and above-left values of every channel stay in registers; the
+    // left neighbour makes this a serial chain per channel, about half the
+    // speed of the LZ decode
+    template <size_t Channels>
+    static void unfilterGradientPixels(unsigned char* line, const unsigned char* above, size_t width)
+    {
+        int left[Channels], above_left[Channels];
+        for (size_t c = 0; c < Channels; ++c) {
+            left[c] = line[c] = (unsigned char)(line[c] + above[c]);
+            above_left[c] = above[c];
+        }
+        for (size_t x = 1; x < width; ++x) {
+            for (size_t c = 0; c < Channels; ++c) {
+                int up = above[x * Channels + c];
+                int predicted = left[c] + up - above_left[c];
+                predicted = predicted < 0 ? 0 : predicted;
+                predicted = predicted > 255 ? 255 : predicted;
+                left[c] = (line[x * Channels + c] + predicted) & 0xFF;
+                line[x * Channels + c] = (unsigned char)left[c];
+                above_left[c] = up;
+            }
+        }
+    }
+    // ------------------------------------------------------------------------
+    bool validate() const
+    {
+        if (size < sizeof(TexelBlocksHeader))
+            return false;
+        const TexelBlocksHeader& h = header();
+        if (h.magic != TEXEL_BLOCKS_MAGIC || h.version != TEXEL_BLOCKS_VERSION)
+            return false;
+        if (h.width == 0 || h.height == 0 || h.channels == 0 || h.channels > 4 || h.rows_per_block == 0 ||
+            h.rows_per_block > TEXEL_BLOCKS_MAX_ROWS)
+            return false;
+        if (h.block_count != (h.height + h.rows_per_block - 1) / h.rows_per_block)
+            return false;
+        if (h.block_offset % alignof(TexelBlock) != 0 ||
+            (uint64_t)h.block_offset + (uint64_t)h.block_count * sizeof(TexelBlock) > size)
+            return false;
+        for (uint32_t i = 0; i < h.block_count; ++i) {
+            const TexelBlock& block = blocks()[i];
+            if (block.offset > size || block.size > size - block.offset)
+                return false;
+            if (block.rows != std::min(h.rows_per_block, h.height - i * h.rows_per_block) || block.filter >= TEXEL_FILTER_COUNT)
+                return false;
+        }
+        return true;
+    }
+};
+
+// the texels of a container, decoded on `threads` threads (0: one per core).
+// When `sourcePath` names an existing file, a container packed from a
+// different version of it is rejected (empty image, nothing printed) so the
+// caller falls back to the source
+inline TexelImage loadTexelBlocks(const std::string& path, bool flipVertically, const std::string& sourcePath = std::string(),
+                                  unsigned threads = 0, TexelDecodeStats* stats = nullptr) {
+    TexelImage image;
+    TexelBlockFile blocks;
+    if (!blocks.open(path))
+        return image;
+    const TexelBlocksHeader& header = blocks.header();
+    if (header.flipped != (flipVertically ? 1u : 0u))
+        return image;
+    if (!sourcePath.empty()) {
+        MappedFile source;
+        if (source.open(sourcePath) &&
+            (source.size() != header.source_size || hashBytes64(source.data(), source.size()) != header.source_hash))
+            return image;
+    }
+
+    TexelDecodeStats local;
+    TexelDecodeStats& result = stats ? *stats : local;
+    image.owned.resize(blocks.imageBytes());
+    if (!blocks.decodeRows(0, header.height, image.owned.data(), threads, &result)) {
+        std::cout << "ERROR::TEXELS::BLOCK_DECODE_FAILED: " << path << std::endl;
+        image.owned.clear();
+        return image;
+    }
+    image.width = (int)header.width;
+    image.height = (int)header.height;
+    image.channels = (int)header.channels;
+    image.pixels = image.owned.data();
+    std::cout << "TEXELS::BLOCKS: " << path << " " << result.blocks << " blocks on " << result.threads << " threads, "
+              << result.bytes << " bytes in " << result.milliseconds << " ms (" << result.megabytesPerSecond()
+              << " MB/s, " << result.megabytesPerSecondPerCore() << " MB/s per core)" << std::endl;
+    return image;
+}
+
+#endif
@@ -0,0 +1,194 @@
+#ifndef MSDF_TEXEL_CACHE_H
+#define MSDF_TEXEL_CACHE_H
+
+// Upload-ready texel cache for atlas textures. The first load of a PNG
+// decodes it with stb_image (already flipped for GL and in the file's channel
+// layout) and stores the raw texels next to it as "<image>.texels", keyed by
+// a hash of the PNG bytes. Warm starts map the cache file and hand the mapped
+// texels straight to glTexImage2D: no inflate, no unfilter, no row flip.
+//
+// Cache file layout: TexelCacheHeader, padding, texels at data_offset.
+
+#include <msdf_hash.h>
+#include <msdf_mapped_file.h>
+#include <stb_image.h>
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+const uint32_t TEXEL_CACHE_MAGIC       = 0x5444534D; // "MSDT"
+const uint32_t TEXEL_CACHE_VERSION     = 1;
+const uint32_t TEXEL_CACHE_DATA_OFFSET = 64;
+
+struct TexelCacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t source_hash;       // hashBytes64() of the source image file
+    uint64_t source_size;
+    uint32_t width;
+    uint32_t height;
+    uint32_t channels;
+    uint32_t flipped;           // 1 when rows are stored bottom-up (GL order)
+    uint32_t data_offset;
+    uint32_t data_size;
+};
+
+static_assert(sizeof(TexelCacheHeader) <= TEXEL_CACHE_DATA_OFFSET, "TexelCacheHeader must fit before the texels");
+
+// texels ready for glTexImage2D: mapped from the cache, decoded by stb_image
+// or decompressed from a block container;
+// move-only, call release() (or let it go out of scope) after the upload
+class TexelImage
+{
+public:
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    const unsigned char* pixels = nullptr;
+    bool fromCache = false;
+
+    TexelImage() {}
+    ~TexelImage() { release(); }
+
+    TexelImage(const TexelImage&) = delete;
+    TexelImage& operator=(const TexelImage&) = delete;
+
+    TexelImage(TexelImage&& other) noexcept { *this = std::move(other); }
+    TexelImage& operator=(TexelImage&& other) noexcept
+    {
+        if (this != &other) {
+            release();
+            width = other.width;
+            height = other.height;
+            channels = other.channels;
+            pixels = other.pixels;
+            fromCache = other.fromCache;
+            decoded = other.decoded;
+            cache = std::move(other.cache);
+            owned = std::move(other.owned);
+            other.pixels = nullptr;
+            other.decoded = nullptr;
+        }
+        return *this;
+    }
+
+    // ------------------------------------------------------------------------
+    void release()
+    {
+        stbi_image_free(decoded);
+        decoded = nullptr;
+        cache.close();
+        owned = std::vector<unsigned char>();
+        pixels = nullptr;
+    }
+
+private:
+    unsigned char* decoded = nullptr;   // stb_image buffer on a cache miss
+    MappedFile cache;                   // cache mapping on a hit
+    std::vector<unsigned char> owned;   // decompressed block container
+
+    friend TexelImage loadTexels(const std::string& path, bool flipVertically, std::string cachePath);
+    friend TexelImage loadTexelBlocks(const std::string& path, bool flipVertically, const std::string& sourcePath,
+                                      unsigned threads, struct TexelDecodeStats* stats);
+};
+
+// a temporary name next to `cachePath` that no other process (pid) or
+// thread (counter) writing the same cache uses
+inline std::string texelCacheTempPath(const std::string& cachePath) {
+    static std::atomic<uint32_t> counter{ 0 };
+#ifdef _WIN32
+    unsigned long pid = (unsigned long)GetCurrentProcessId();
+#else
+    unsigned long pid = (unsigned long)getpid();
+#endif
+    return cachePath + "." + std::to_string(pid) + "." + std::to_string(counter.fetch_add(1)) + ".tmp";
+}
+
+// the texels of the image at `path`, from `cachePath` (default "<path>.texels")
+// when it matches the current file, otherwise decoded and written to the cache
+inline TexelImage loadTexels(const std::string& path, bool flipVertically, std::string cachePath = std::string()) {
+    TexelImage image;
+    if (cachePath.empty())
+        cachePath = path + ".texels";
+
+    MappedFile source;
+    if (!source.open(path)) {
+        std::cout << "ERROR::TEXELS::FILE_NOT_SUCCESSFULLY_READ: " << path << std::endl;
+        return image;
+    }
+    uint64_t hash = hashBytes64(source.data(), source.size());
+
+    // warm start: the cache matches the source, use the mapped texels in place
+    if (image.cache.open(cachePath) && image.cache.size() >= TEXEL_CACHE_DATA_OFFSET) {
+        TexelCacheHeader header;
+        memcpy(&header, image.cache.data(), sizeof(header));
+        if (header.magic == TEXEL_CACHE_MAGIC && header.version == TEXEL_CACHE_VERSION &&
+            header.source_hash == hash && header.source_size == source.size() &&
+            header.flipped == (flipVertically ? 1u : 0u) &&
+            header.data_size == (uint64_t)header.width * header.height * header.channels &&
+            (uint64_t)header.data_offset + header.data_size <= image.cache.size()) {
+            image.width = (int)header.width;
+            image.height = (int)header.height;
+            image.channels = (int)header.channels;
+            image.pixels = image.cache.data() + header.data_offset;
+            image.fromCache = true;
+            return image;
+        }
+    }
+    image.cache.close();
+
+    // cold start: decode the PNG and store the upload-ready texels
+    stbi_set_flip_vertically_on_load_thread(flipVertically ? 1 : 0);
+    image.decoded = stbi_load_from_memory(source.data(), (int)source.size(), &image.width, &image.height, &image.channels, 0);
+    if (image.decoded == nullptr) {
+        std::cout << "ERROR::TEXELS::DECODE_FAILED: " << path << " " << stbi_failure_reason() << std::endl;
+        return image;
+    }
+    image.pixels = image.decoded;
+
+    TexelCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = TEXEL_CACHE_MAGIC;
+    header.version = TEXEL_CACHE_VERSION;
+    header.source_hash = hash;
+    header.source_size = source.size();
+    header.width = (uint32_t)image.width;
+    header.height = (uint32_t)image.height;
+    header.channels = (uint32_t)image.channels;
+    header.flipped = flipVertically ? 1 : 0;
+    header.data_offset = TEXEL_CACHE_DATA_OFFSET;
+    header.data_size = header.width * header.height * header.channels;
+
+    // write to a temporary file and rename, so a reader never maps a partial cache
+    std::cout << "Caching texels of " << path << " in " << cachePath << std::endl;
+    std::string tempPath = texelCacheTempPath(cachePath);
+    {
+        std::ofstream outputFile(tempPath, std::ios::binary | std::ios::trunc);
+        std::vector<char> prefix(TEXEL_CACHE_DATA_OFFSET, 0);
+        memcpy(prefix.data(), &header, sizeof(header));
+        outputFile.write(prefix.data(), prefix.size());
+        outputFile.write(reinterpret_cast<const char*>(image.pixels), header.data_size);
+        if (!outputFile.good()) {
+            std::cout << "ERROR::TEXELS::CACHE_NOT_WRITTEN: " << cachePath << std::endl;
+            outputFile.close();
+            std::remove(tempPath.c_str());
+            return image;
+        }
+    }
+#ifdef _WIN32
+    // rename does not replace an existing file on Windows
+    std::remove(cachePath.c_str());
+#endif
+    // atomic on POSIX: a concurrent writer's rename replaces the same texels
+    if (std::rename(tempPath.c_str(), cachePath.c_str()) != 0)
+        std::remove(tempPath.c_str());
+    return image;
+}
+
+#endif
@@ -0,0 +1,385 @@
+#ifndef MSDF_TEXT_EDIT_H
+#define MSDF_TEXT_EDIT_H
+
+// Editable text: a piece table for the bytes and a per-line layout cache
+// over one shared vertex buffer.
+//
+// The piece table never moves text: the original string and an append-only
+// buffer of inserted bytes are stitched together by a list of pieces, so an
+// edit splits at most one piece. Typing at the end of the previous insertion
+// only grows its piece.
+//
+// Every line ('\n' ends a line) owns a contiguous vertex slice with room for
+// EDIT_LINE_SLACK more quads (a line that outgrows its slice gets twice its
+// size), and keeps its page ranges. An edit lays out
+// again only the lines it touches, from the edited line up to the next '\n'
+// after the edit (the next stable break):
+//
+//   - while the line still fits its slice, the quads are patched in place and
+//     the unused slack is zeroed (degenerate quads, never rasterized)
+//   - otherwise the lines get new slices that are spliced into the buffer;
+//     the lines below move, and when the line count changed their y is
+//     shifted, but none of them is laid out again
+//
+// dirty() reports the float range that changed since the last clearDirty(),
+// for a glBufferSubData of just that range.
+
+#include <msdf_atlas_pages.h>
+#include <msdf_font.h>
+#include <msdf_text_layout.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+const size_t EDIT_LINE_SLACK = 8;       // spare quads per line slice
+
+class PieceTable
+{
+public:
+    explicit PieceTable(std::string_view text = std::string_view()) : original(text)
+    {
+        if (!original.empty())
+            pieces.push_back({ false, 0, original.size() });
+        total = original.size();
+    }
+
+    // ------------------------------------------------------------------------
+    void insert(size_t offset, std::string_view text)
+    {
+        if (text.empty())
+            return;
+        if (offset > total)
+            offset = total;
+        size_t start = added.size();
+        added.append(text.data(), text.size());
+        total += text.size();
+
+        size_t within;
+        size_t index = find(offset, within);
+        // typing right after the last insertion extends its piece
+        if (within == 0 && index > 0) {
+            Piece& previous = pieces[index - 1];
+            if (previous.added && previous.start + previous.length == start) {
+                previous.length += text.size();
+                return;
+            }
+        }
+        if (within != 0) {
+            Piece tail = pieces[index];
+            tail.start += within;
+            tail.length -= within;
+            pieces[index].length = within;
+            pieces.insert(pieces.begin() + index + 1, tail);
+            ++index;
+        }
+        pieces.insert(pieces.begin() + index, Piece{ true, start, text.size() });
+    }
+    // ------------------------------------------------------------------------
+    void erase(size_t offset, size_t length)
+    {
+        if (offset >= total)
+            return;
+        length = std::min(length, total - offset);
+        total -= length;
+
+        size_t within;
+        size_t index = find(offset, within);
+        if (within != 0) {
+            // split so the erase starts on a piece boundary
+            Piece tail = pieces[index];
+            tail.start += within;
+            tail.length -= within;
+            pieces[index].length = within;
+            pieces.insert(pieces.begin() + index + 1, tail);
+            ++index;
+        }
+        size_t last = index;
+        while (length > 0 && last < pieces.size()) {
+            if (pieces[last].length <= length) {
+                length -= pieces[last].length;
+                ++last;
+            } else {
+                pieces[last].start += length;
+                pieces[last].length -= length;
+                length = 0;
+            }
+        }
+        pieces.erase(pieces.begin() + index, pieces.begin() + last);
+    }
+
+    // `length` bytes from `offset` into `out` (replaced)
+    // ------------------------------------------------------------------------
+    void copy(size_t offset, size_t length, std::string& out) const
+    {
+        out.clear();
+        if (offset >= total)
+            return;
+        length = std::min(length, total - offset);
+        size_t within;
+        for (size_t index = find(offset, within); length > 0 && index < pieces.size(); ++index, within = 0) {
+            const Piece& piece = pieces[index];
+            size_t take = std::min(piece.length - within, length);
+            out.append(bytes(piece) + within, take);
+            length -= take;
+        }
+    }
+    std::string text() const
+    {
+        std::string out;
+        copy(0, total, out);
+        return out;
+    }
+
+    size_t size() const { return total; }
+    size_t pieceCount() const { return pieces.size(); }
+
+private:
+    struct Piece {
+        bool added;             // in the add buffer, else in the original
+        size_t start;
+        size_t length;
+    };
+
+    std::string original;
+    std::string added;
+    std::vector<Piece> pieces;
+    size_t total = 0;
+
+    const char* bytes(const Piece& piece) const { return (piece.added ? added.data() : original.data()) + piece.start; }
+
+    // the piece holding `offset` and the offset within it; pieces.size() at the end
+    size_t find(size_t offset, size_t& within) const
+    {
+        for (size_t index = 0; index < pieces.size(); ++index) {
+            if (offset < pieces[index].length) {
+                within = offset;
+                return index;
+            }
+            offset -= pieces[index].length;
+        }
+        within = 0;
+        return pieces.size();
+    }
+};
+
+class EditableText
+{
+public:
+    EditableText(const Font& font, float scale, std::string_view text = std::string_view())
+        : font(font), scale(scale), buffer(text)
+    {
+        lines.push_back({ 0, 0, 0, 0, {} });
+        for (size_t i = 0; i < text.size(); ++i)
+            if (text[i] == '\n')
+                lines.push_back({ i + 1, 0, 0, 0, {} });
+        relayout(0, 0, lines.size(), 0, 0);
+    }
+
+    // ------------------------------------------------------------------------
+    void insert(size_t offset, std::string_view text)
+    {
+        offset = std::min(offset, buffer.size());
+        if (text.empty())
+            return;
+        size_t line = lineOf(offset);
+        size_t begin_vertex = lines[line].first;
+        size_t end_vertex = begin_vertex + lines[line].capacity;
+        buffer.insert(offset, text);
+
+        for (size_t i = line + 1; i < lines.size(); ++i)
+            lines[i].begin += text.size();
+        std::vector<Line> inserted;
+        for (size_t i = 0; i < text.size(); ++i)
+            if (text[i] == '\n')
+                inserted.push_back({ offset + i + 1, 0, 0, 0, {} });
+        lines.insert(lines.begin() + line + 1, inserted.begin(), inserted.end());
+        relayout(line, 1, inserted.size() + 1, begin_vertex, end_vertex);
+    }
+    // ------------------------------------------------------------------------
+    void erase(size_t offset, size_t length)
+    {
+        if (offset >= buffer.size() || length == 0)
+            return;
+        length = std::min(length, buffer.size() - offset);
+        size_t first = lineOf(offset);
+        size_t last = lineOf(offset + length);      // merges into `first`
+        size_t begin_vertex = lines[first].first;
+        size_t end_vertex = (size_t)lines[last].first + lines[last].capacity;
+        buffer.erase(offset, length);
+
+        for (size_t i = last + 1; i < lines.size(); ++i)
+            lines[i].begin -= length;
+        lines.erase(lines.begin() + first + 1, lines.begin() + last + 1);
+        relayout(first, last - first + 1, 1, begin_vertex, end_vertex);
+    }
+
+    // the line holding byte `offset`
+    // ------------------------------------------------------------------------
+    size_t lineOf(size_t offset) const
+    {
+        auto it = std::upper_bound(lines.begin(), lines.end(), offset, [](size_t value, const Line& line) { return value < line.begin; });
+        return (size_t)(it - lines.begin()) - 1;
+    }
+
+    // the draw ranges of all lines; ranges on one page are merged across
+    // the zeroed slack between them
+    // ------------------------------------------------------------------------
+    void ranges(std::vector<PageRange>& out) const
+    {
+        out.clear();
+        for (const Line& line : lines)
+            for (const PageRange& range : line.ranges) {
+                uint32_t first = line.first + range.first;
+                if (!out.empty() && out.back().page == range.page)
+                    out.back().count = first + range.count - out.back().first;
+                else
+                    out.push_back({ range.page, first, range.count });
+            }
+    }
+
+    // floats of vertices() changed since clearDirty(); false when none did
+    bool dirty(size_t& first, size_t& end) const
+    {
+        first = dirty_first;
+        end = dirty_end;
+        return dirty_first < dirty_end;
+    }
+    void clearDirty()
+    {
+        dirty_first = (size_t)-1;
+        dirty_end = 0;
+    }
+
+    const PieceTable& text() const { return buffer; }
+    const std::vector<float>& vertices() const { return vertex_data; }      // top of the first line at y = 0
+    size_t lineCount() const { return lines.size(); }
+    size_t lineBegin(size_t line) const { return lines[line].begin; }
+    void lineSlice(size_t line, uint32_t& first, uint32_t& count) const
+    {
+        first = lines[line].first;
+        count = lines[line].count;
+    }
+    float lineHeight() const { return font.metrics().line_height * scale; }
+    size_t relaidLines() const { return relaid_lines; }
+
+private:
+    struct Line {
+        size_t begin;                   // byte offset of the line in the text
+        uint32_t first;                 // first vertex of the line's slice
+        uint32_t count;                 // vertices
+        uint32_t capacity;              // vertices in the slice, count plus slack
+        std::vector<PageRange> ranges;  // relative to the slice
+    };
+
+    const Font& font;
+    float scale;
+    PieceTable buffer;
+    std::vector<Line> lines;
+    std::vector<float> vertex_data;
+    size_t dirty_first = (size_t)-1;
+    size_t dirty_end = 0;
+    size_t relaid_lines = 0;
+
+    // scratch reused by every relayout
+    std::string line_text;
+    std::vector<float> line_vertices;
+    std::vector<PageRange> line_ranges;
+    std::vector<float> laid_vertices;
+
+    size_t lineEnd(size_t line) const
+    {
+        // the '\n' is not part of the laid out text
+        return line + 1 < lines.size() ? lines[line + 1].begin - 1 : buffer.size();
+    }
+
+    // lay out one line into line_vertices; returns its vertex count
+    uint32_t layoutLine(size_t line)
+    {
+        const AtlasBinHeader& metrics = font.metrics();
+        size_t begin = lines[line].begin;
+        buffer.copy(begin, lineEnd(line) - begin, line_text);
+        if (line_vertices.size() < line_text.size() * LAYOUT_QUAD_FLOATS)
+            line_vertices.resize(line_text.size() * LAYOUT_QUAD_FLOATS);
+        if (line_ranges.size() < line_text.size())
+            line_ranges.resize(line_text.size());
+        LayoutTarget target(line_vertices.data(), line_text.size(), line_ranges.data(), line_ranges.size());
+        float baseline = -metrics.ascender * scale - (float)line * metrics.line_height * scale;
+        size_t glyphs = layoutText(font, line_text, 0.0f, baseline, scale, target);
+        lines[line].ranges.assign(line_ranges.begin(), line_ranges.begin() + target.range_count);
+        ++relaid_lines;
+        return (uint32_t)(glyphs * LAYOUT_QUAD_VERTICES);
+    }
+
+    void markDirty(size_t firstFloat, size_t endFloat)
+    {
+        dirty_first = std::min(dirty_first, firstFloat);
+        dirty_end = std::max(dirty_end, endFloat);
+    }
+
+    // lines [first, first + newCount) replace `oldCount` lines whose slices
+    // covered vertices [beginVertex, endVertex)
+    void relayout(size_t first, size_t oldCount, size_t newCount, size_t beginVertex, size_t endVertex)
+    {
+        size_t begin_float = beginVertex * LAYOUT_VERTEX_FLOATS;
+        size_t old_floats = (endVertex - beginVertex) * LAYOUT_VERTEX_FLOATS;
+        bool single = oldCount == 1 && newCount == 1;
+        uint32_t single_count = 0;
+
+        // one line that still fits its slice: patch in place
+        if (single) {
+            single_count = layoutLine(first);
+            if (single_count <= endVertex - beginVertex) {
+                size_t floats = (size_t)single_count * LAYOUT_VERTEX_FLOATS;
+                std::copy(line_vertices.begin(), line_vertices.begin() + floats, vertex_data.begin() + begin_float);
+                std::fill(vertex_data.begin() + begin_float + floats, vertex_data.begin() + begin_float + old_floats, 0.0f);
+                lines[first].count = single_count;
+                markDirty(begin_float, begin_float + old_floats);
+                return;
+            }
+        }
+
+        // new slices for the lines, laid out back to back (a single line that
+        // outgrew its slice already is)
+        std::vector<float>& laid = laid_vertices;
+        laid.clear();
+        uint32_t vertex = (uint32_t)beginVertex;
+        for (size_t line = first; line < first + newCount; ++line) {
+            uint32_t count = single ? single_count : layoutLine(line);
+            uint32_t slack = (uint32_t)(EDIT_LINE_SLACK * LAYOUT_QUAD_VERTICES);
+            if (single && count > slack)
+                slack = count;      // a line being typed into: double its slice
+            uint32_t capacity = count + slack;
+            lines[line].first = vertex;
+            lines[line].count = count;
+            lines[line].capacity = capacity;
+            laid.insert(laid.end(), line_vertices.begin(), line_vertices.begin() + (size_t)count * LAYOUT_VERTEX_FLOATS);
+            laid.resize(laid.size() + (size_t)(capacity - count) * LAYOUT_VERTEX_FLOATS, 0.0f);
+            vertex += capacity;
+        }
+
+        // splice, then move and shift what follows
+        vertex_data.erase(vertex_data.begin() + begin_float, vertex_data.begin() + begin_float + old_floats);
+        vertex_data.insert(vertex_data.begin() + begin_float, laid.begin(), laid.end());
+        int64_t vertex_delta = (int64_t)(laid.size() / LAYOUT_VERTEX_FLOATS) - (int64_t)(endVertex - beginVertex);
+        int64_t line_delta = (int64_t)newCount - (int64_t)oldCount;
+        for (size_t line = first + newCount; line < lines.size(); ++line)
+            lines[line].first = (uint32_t)((int64_t)lines[line].first + vertex_delta);
+        size_t tail_float = begin_float + laid.size();
+        if (line_delta != 0) {
+            const AtlasBinHeader& metrics = font.metrics();
+            float shift = -(float)line_delta * metrics.line_height * scale;
+            for (size_t line = first + newCount; line < lines.size(); ++line) {
+                float* vertex = vertex_data.data() + (size_t)lines[line].first * LAYOUT_VERTEX_FLOATS;
+                for (uint32_t v = 0; v < lines[line].count; ++v, vertex += LAYOUT_VERTEX_FLOATS)
+                    vertex[1] += shift;
+            }
+        }
+        markDirty(begin_float, (vertex_delta != 0 || line_delta != 0) ? vertex_data.size() : tail_float);
+    }
+};
+
+#endif
@@ -0,0 +1,634 @@
+#ifndef MSDF_TEXT_LAYOUT_H
+#define MSDF_TEXT_LAYOUT_H
+
+// Allocation-free text layout. layoutText() writes the quads of a string
+// (4 vertices of position, color, texcoords per visible glyph) into memory
+// the caller owns, usually a slice of the per-frame FrameArena, and returns
+// the number of glyphs written; nothing touches the heap. Consecutive quads on
+// the same atlas page are reported as PageRanges, so text on one page is a
+// single draw without reordering. A quad holds its unique corners only and is
+// drawn as two triangles through a shared static index buffer
+// (msdf_quad_indices.h); PageRanges count vertices, 4 per glyph.
+//
+// Instead of quads, layout can write one GlyphInstance per glyph (screen
+// rect, atlas UV rect, style) for the instanced path: a unit quad per record
+// expanded in shaders/4.2.texture_instanced.vs (see msdf_glyph_instances.h),
+// or compact quads of 8 (12 with color) byte vertices: int16 positions
+// relative to the layout origin and unorm16 UVs (see msdf_compact_vertices.h),
+// or one 8 byte PulledGlyph per glyph (pen x and glyph index) for vertex
+// pulling, where the shader reads bounds and UVs from a glyph table uploaded
+// once per font (see msdf_glyph_pulling.h).
+//
+// The text is UTF-8 in a std::string_view (see msdf_utf8.h; a string never
+// has more codepoints than bytes, so text.size() glyphs is always enough
+// room) or a span of codepoints.
+//
+// The loop runs in two phases: glyph lookup, kerning and the pen position
+// are resolved for a batch of LAYOUT_BATCH glyphs first, then the quads of
+// the batch are built with SIMD shuffles (AVX: one 256-bit store per vertex,
+// SSE2: two 128-bit stores) or the scalar fallback; the emit phase has no
+// loop-carried dependency. Build with /arch:AVX2 (-mavx2) for the AVX path.
+
+#include <msdf_atlas_pages.h>
+#include <msdf_font.h>
+#include <msdf_glyph_store.h>
+#include <msdf_utf8.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string_view>
+
+const size_t LAYOUT_QUAD_VERTICES = 4;  // unique corners: x1y1, x1y0, x0y1, x0y0
+const size_t LAYOUT_QUAD_INDICES = 6;   // two triangles over the corners, LAYOUT_QUAD_PATTERN
+const size_t LAYOUT_VERTEX_FLOATS = 8;  // position (3), color (3), texcoords (2)
+const size_t LAYOUT_QUAD_FLOATS = LAYOUT_QUAD_VERTICES * LAYOUT_VERTEX_FLOATS;
+const size_t LAYOUT_BATCH = 16;         // glyphs resolved before their quads are built
+const size_t LAYOUT_DECODE_CHUNK = 256; // codepoints decoded per step of layoutText()
+const size_t LAYOUT_COMPACT_VERTEX_BYTES = 8;       // int16 x, y; unorm16 u, v
+const size_t LAYOUT_COMPACT_COLOR_BYTES = 12;       // the same plus RGBA8
+const float LAYOUT_COMPACT_SUBPIXEL = 8.0f;         // position steps per pixel: +-4096 px around the origin
+
+// corner indices of the two triangles of a quad, both clockwise with y up
+const uint32_t LAYOUT_QUAD_PATTERN[LAYOUT_QUAD_INDICES] = { 0, 1, 2, 1, 3, 2 };
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define MSDF_LAYOUT_AVX 1
+#endif
+
+// one glyph of the instanced path, 36 bytes against the 128 of a quad
+struct GlyphInstance {
+    float rect[4];                      // x0 y0 x1 y1, plane bounds placed at the pen
+    float uv[4];                        // u0 v0 u1 v1, normalized atlas UVs
+    uint32_t style;                     // index into the shader's style table
+};
+static_assert(sizeof(GlyphInstance) == 36, "GlyphInstance is 9 texels of the instance record buffer");
+
+// one glyph of the vertex pulling path: everything but the pen comes from the
+// font's glyph table on the GPU
+struct PulledGlyph {
+    float pen_x;                        // relative to the layout origin
+    uint16_t glyph;                     // GlyphStore index, the glyph table row
+    uint16_t style;                     // index into the shader's style table
+};
+static_assert(sizeof(PulledGlyph) == 8, "PulledGlyph is the RG32UI texel of the glyph records");
+
+// bump allocator reset once per frame; its block is reserved up front, so
+// allocating during a frame never reaches the heap
+class FrameArena
+{
+public:
+    explicit FrameArena(size_t bytes = 0) { reserve(bytes); }
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    // (re)allocate the block; startup only, drops everything allocated
+    // ------------------------------------------------------------------------
+    void reserve(size_t bytes)
+    {
+        block.reset(bytes ? new unsigned char[bytes] : nullptr);
+        capacity_bytes = bytes;
+        used_bytes = 0;
+    }
+    // `count` objects of T, uninitialized; nullptr when the arena is full
+    // ------------------------------------------------------------------------
+    template <typename T>
+    T* allocate(size_t count)
+    {
+        uintptr_t base = reinterpret_cast<uintptr_t>(block.get());
+        size_t offset = (size_t)(((base + used_bytes + alignof(T) - 1) & ~(uintptr_t)(alignof(T) - 1)) - base);
+        if (offset > capacity_bytes || count > (capacity_bytes - offset) / sizeof(T))
+            return nullptr;
+        used_bytes = offset + count * sizeof(T);
+        if (used_bytes > high_water)
+            high_water = used_bytes;
+        return reinterpret_cast<T*>(block.get() + offset);
+    }
+    // free everything allocated this frame
+    void reset() { used_bytes = 0; }
+
+    size_t used() const { return used_bytes; }
+    size_t capacity() const { return capacity_bytes; }
+    size_t highWater() const { return high_water; }
+
+private:
+    std::unique_ptr<unsigned char[]> block;
+    size_t capacity_bytes = 0;
+    size_t used_bytes = 0;
+    size_t high_water = 0;
+};
+
+// where layoutText() writes; ranges are optional
+struct LayoutTarget {
+    float* vertices = nullptr;          // LAYOUT_QUAD_FLOATS per glyph
+    GlyphInstance* instances = nullptr; // or one instance per glyph when set (vertices stays null)
+    uint32_t style = 0;                 // written to every instance
+    unsigned char* compact = nullptr;   // or compact quads, 4 vertices of compact_stride bytes per glyph
+    size_t compact_stride = LAYOUT_COMPACT_VERTEX_BYTES;
+    uint32_t color = 0xFFFFFFFF;        // RGBA8 (R in the lowest byte) of compact vertices with color
+    PulledGlyph* pulled = nullptr;      // or one glyph record per glyph; y is not stored, the draw supplies it
+    size_t capacity = 0;                // in glyphs
+    PageRange* ranges = nullptr;        // runs of consecutive quads on one page, first relative to vertices
+                                        // (in vertices, or in instances / records for those targets)
+    size_t range_capacity = 0;
+    size_t range_count = 0;             // out
+    float* pens = nullptr;              // optional prefix advance index (msdf_advance_index.h): pen x of
+    size_t pen_capacity = 0;            // every codepoint laid out, then the end pen; text.size() + 1 is enough
+    size_t pen_count = 0;               // out
+
+    LayoutTarget() {}
+    LayoutTarget(float* vertices, size_t capacity, PageRange* ranges = nullptr, size_t rangeCapacity = 0)
+        : vertices(vertices), capacity(capacity), ranges(ranges), range_capacity(rangeCapacity) {}
+
+    // a target of `glyphs` quads and ranges carved from an arena; empty when it is full
+    static LayoutTarget fromArena(FrameArena& arena, size_t glyphs, size_t maxRanges = 0)
+    {
+        float* vertices = arena.allocate<float>(glyphs * LAYOUT_QUAD_FLOATS);
+        PageRange* ranges = maxRanges ? arena.allocate<PageRange>(maxRanges) : nullptr;
+        if (vertices == nullptr || (maxRanges && ranges == nullptr))
+            return LayoutTarget();
+        return LayoutTarget(vertices, glyphs, ranges, maxRanges);
+    }
+    // a target writing GlyphInstances instead of quads
+    static LayoutTarget instanced(GlyphInstance* instances, size_t capacity, PageRange* ranges = nullptr,
+                                  size_t rangeCapacity = 0, uint32_t style = 0)
+    {
+        LayoutTarget target(nullptr, capacity, ranges, rangeCapacity);
+        target.instances = instances;
+        target.style = style;
+        return target;
+    }
+    // a target writing compact quads, with an RGBA8 color per vertex when withColor
+    static LayoutTarget compactQuads(void* vertices, size_t capacity, PageRange* ranges = nullptr, size_t rangeCapacity = 0,
+                                     bool withColor = false, uint32_t color = 0xFFFFFFFF)
+    {
+        LayoutTarget target(nullptr, capacity, ranges, rangeCapacity);
+        target.compact = static_cast<unsigned char*>(vertices);
+        target.compact_stride = withColor ? LAYOUT_COMPACT_COLOR_BYTES : LAYOUT_COMPACT_VERTEX_BYTES;
+        target.color = color;
+        return target;
+    }
+    // a target writing PulledGlyph records for vertex pulling
+    static LayoutTarget pulledGlyphs(PulledGlyph* glyphs, size_t capacity, PageRange* ranges = nullptr,
+                                     size_t rangeCapacity = 0, uint32_t style = 0)
+    {
+        LayoutTarget target(nullptr, capacity, ranges, rangeCapacity);
+        target.pulled = glyphs;
+        target.style = style;
+        return target;
+    }
+};
+
+// one glyph quad at pen (x, y), scalar
+// ------------------------------------------------------------------------
+inline void emitQuadScalar(const GlyphStore& glyphs, uint16_t glyph, float x, float y, float planeScale, float* out) {
+    const GlyphHot& metrics = glyphs.hot()[glyph];
+    const GlyphCold& uv = glyphs.cold()[glyph];
+    const float x0 = x + metrics.pl * planeScale;
+    const float y0 = y + metrics.pb * planeScale;
+    const float x1 = x + metrics.pr * planeScale;
+    const float y1 = y + metrics.pt * planeScale;
+    const float quad[LAYOUT_QUAD_FLOATS] = {
+        //Position                         //TexCoords
+        x1, y1, 0.0f,  1.0f, 0.0f, 0.0f,   uv.u1, uv.v1,
+        x1, y0, 0.0f,  0.0f, 1.0f, 0.0f,   uv.u1, uv.v0,
+        x0, y1, 0.0f,  1.0f, 1.0f, 0.0f,   uv.u0, uv.v1,
+        x0, y0, 0.0f,  0.0f, 0.0f, 1.0f,   uv.u0, uv.v0
+    };
+    memcpy(out, quad, sizeof(quad));
+}
+
+#ifdef MSDF_GLYPH_STORE_SSE2
+// one vertex from corners (x0, y0, x1, y1), uv (u0, v0, u1, v1) and
+// one_zero (0, 1, 0, 1): X/Y pick the corner and the matching UV, R/G/B the
+// vertex color. Each half of the vertex is a single shuffle
+template <int X, int Y, int R, int G, int B>
+inline void emitVertexSimd(float* out, __m128 corners, __m128 uv, __m128 one_zero) {
+    __m128 position = _mm_shuffle_ps(corners, one_zero, _MM_SHUFFLE(R, 0, Y, X));    // x y 0 r
+    __m128 texcoord = _mm_shuffle_ps(one_zero, uv, _MM_SHUFFLE(Y, X, B, G));         // g b u v
+#ifdef MSDF_LAYOUT_AVX
+    _mm256_storeu_ps(out, _mm256_insertf128_ps(_mm256_castps128_ps256(position), texcoord, 1));
+#else
+    _mm_storeu_ps(out, position);
+    _mm_storeu_ps(out + 4, texcoord);
+#endif
+}
+
+// one glyph quad at pen (x, y), same vertices as emitQuadScalar()
+// ------------------------------------------------------------------------
+inline void emitQuadSimd(const GlyphStore& glyphs, uint16_t glyph, float x, float y, float planeScale, float* out) {
+    __m128i bounds = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(&glyphs.hot()[glyph].pl));
+    bounds = _mm_srai_epi32(_mm_unpacklo_epi16(bounds, bounds), 16);
+    __m128 corners = _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(bounds), _mm_set1_ps(planeScale)), _mm_setr_ps(x, y, x, y));
+    __m128 uv = _mm_loadu_ps(&glyphs.cold()[glyph].u0);
+    const __m128 one_zero = _mm_setr_ps(0.0f, 1.0f, 0.0f, 1.0f);
+
+    emitVertexSimd<2, 3, 1, 0, 0>(out + 0 * LAYOUT_VERTEX_FLOATS, corners, uv, one_zero);
+    emitVertexSimd<2, 1, 0, 1, 0>(out + 1 * LAYOUT_VERTEX_FLOATS, corners, uv, one_zero);
+    emitVertexSimd<0, 3, 1, 1, 0>(out + 2 * LAYOUT_VERTEX_FLOATS, corners, uv, one_zero);
+    emitVertexSimd<0, 1, 0, 0, 1>(out + 3 * LAYOUT_VERTEX_FLOATS, corners, uv, one_zero);
+}
+#endif
+
+// the quads of a resolved batch: glyph indices and their pen x
+template <bool Simd>
+inline void emitQuadBatch(const GlyphStore& glyphs, const uint16_t* batchGlyphs, const float* batchPens, size_t count,
+                          float y, float planeScale, float* out) {
+#ifdef MSDF_GLYPH_STORE_SSE2
+    if (Simd) {
+        for (size_t i = 0; i < count; ++i)
+            emitQuadSimd(glyphs, batchGlyphs[i], batchPens[i], y, planeScale, out + i * LAYOUT_QUAD_FLOATS);
+        return;
+    }
+#endif
+    for (size_t i = 0; i < count; ++i)
+        emitQuadScalar(glyphs, batchGlyphs[i], batchPens[i], y, planeScale, out + i * LAYOUT_QUAD_FLOATS);
+}
+
+// the instances of a resolved batch: the same rects and UVs as the quads
+// ------------------------------------------------------------------------
+inline void emitInstanceBatch(const GlyphStore& glyphs, const uint16_t* batchGlyphs, const float* batchPens, size_t count,
+                              float y, float planeScale, uint32_t style, GlyphInstance* out) {
+    for (size_t i = 0; i < count; ++i) {
+        GlyphStore::planeBounds(glyphs.hot()[batchGlyphs[i]], batchPens[i], y, planeScale, out[i].rect);
+        memcpy(out[i].uv, &glyphs.cold()[batchGlyphs[i]], sizeof(out[i].uv));
+        out[i].style = style;
+    }
+}
+
+// the glyph records of a resolved batch: no bounds or UVs are read, the pen
+// is made relative to the origin
+// ------------------------------------------------------------------------
+inline void emitPulledBatch(const uint16_t* batchGlyphs, const float* batchPens, size_t count, float originX,
+                            uint32_t style, PulledGlyph* out) {
+    for (size_t i = 0; i < count; ++i)
+        out[i] = { batchPens[i] - originX, batchGlyphs[i], (uint16_t)style };
+}
+
+// the compact quads of a resolved batch: corners relative to the origin in
+// 1/LAYOUT_COMPACT_SUBPIXEL px, saturated to int16, UVs as unorm16; same
+// corner order as emitQuadScalar(). The color is written when stride has room
+// ------------------------------------------------------------------------
+inline void emitCompactBatch(const GlyphStore& glyphs, const uint16_t* batchGlyphs, const float* batchPens, size_t count,
+                             float y, float planeScale, float originX, float originY, uint32_t color, size_t stride,
+                             unsigned char* out) {
+    const bool with_color = stride >= LAYOUT_COMPACT_COLOR_BYTES;
+    for (size_t i = 0; i < count; ++i) {
+        // x0 y0 x1 y1 as int16, then u0 v0 u1 v1 as unorm16
+        uint16_t q[8];
+        float corners[4];
+        GlyphStore::planeBounds(glyphs.hot()[batchGlyphs[i]], batchPens[i] - originX, y - originY, planeScale, corners);
+        const GlyphCold& uv = glyphs.cold()[batchGlyphs[i]];
+#ifdef MSDF_GLYPH_STORE_SSE2
+        // one rounding convert each, the signed pack saturates; UVs are packed
+        // biased by -32768 and flipped back to unsigned
+        __m128i position = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(corners), _mm_set1_ps(LAYOUT_COMPACT_SUBPIXEL)));
+        __m128 unit = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(&uv.u0), _mm_setzero_ps()), _mm_set1_ps(1.0f));
+        __m128i texcoord = _mm_cvtps_epi32(_mm_sub_ps(_mm_mul_ps(unit, _mm_set1_ps(65535.0f)), _mm_set1_ps(32768.0f)));
+        __m128i packed = _mm_xor_si128(_mm_packs_epi32(position, texcoord), _mm_setr_epi16(0, 0, 0, 0, -32768, -32768, -32768, -32768));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(q), packed);
+#else
+        const float units[4] = { uv.u0, uv.v0, uv.u1, uv.v1 };
+        for (int c = 0; c < 4; ++c) {
+            float step = std::nearbyint(corners[c] * LAYOUT_COMPACT_SUBPIXEL);
+            q[c] = (uint16_t)(int16_t)std::min(32767.0f, std::max(-32768.0f, step));
+            q[4 + c] = (uint16_t)std::nearbyint(std::min(1.0f, std::max(0.0f, units[c])) * 65535.0f);
+        }
+#endif
+        // the four corners as whole vertices (x y u v, little endian), x from
+        // corner cx (0 or 2), y from cy
+        auto corner = [&q](int cx, int cy) -> uint64_t {
+            return q[cx] | (uint64_t)q[cy + 1] << 16 | (uint64_t)q[4 + cx] << 32 | (uint64_t)q[5 + cy] << 48;
+        };
+        const uint64_t x1y1 = corner(2, 2), x1y0 = corner(2, 0), x0y1 = corner(0, 2), x0y0 = corner(0, 0);
+        const uint64_t quad[LAYOUT_QUAD_VERTICES] = { x1y1, x1y0, x0y1, x0y0 };
+        unsigned char* target = out + i * LAYOUT_QUAD_VERTICES * stride;
+        if (!with_color) {
+            memcpy(target, quad, sizeof(quad));
+            continue;
+        }
+        for (size_t v = 0; v < LAYOUT_QUAD_VERTICES; ++v) {
+            memcpy(target + v * stride, &quad[v], sizeof(quad[v]));
+            memcpy(target + v * stride + sizeof(quad[v]), &color, sizeof(color));
+        }
+    }
+}
+
+// the layout loop as a resumable cursor: pen, kerning state and the pending
+// batch carry over between feed() calls, so text decoded in chunks lays out
+// exactly like one run. Stops for good when the target is full (glyphs) or
+// out of ranges, and lays out nothing for a scale <= 0. Simd = false forces
+// the scalar quad emitter
+template <bool Simd = true>
+class LayoutCursor
+{
+public:
+    LayoutCursor(const Font& font, float x, float y, float scale, LayoutTarget& target)
+        : font(font), glyphs(font.glyphs()), target(target), x(x), y(y), scale(scale), origin_x(x),
+          plane_scale(font.glyphs().planeUnit() * scale),
+          range_unit(target.instances || target.pulled ? 1 : (uint32_t)LAYOUT_QUAD_VERTICES)
+    {
+        target.range_count = 0;
+        target.pen_count = 0;
+        prev_row = font.asciiMetrics().usable() ? ASCII_ROW_START : ASCII_ROW_OTHER;
+        stopped = !(scale > 0.0f);
+    }
+
+    // lay out more codepoints; false once the cursor has stopped
+    // ------------------------------------------------------------------------
+    template <typename Codepoint>
+    bool feed(const Codepoint* first, const Codepoint* last)
+    {
+        // the hot glyph records carry advance, plane bounds and kerning, UVs and
+        // page are read for visible glyphs only. ASCII after ASCII takes its
+        // glyph and its kerned advance from the font's AsciiMetrics, as
+        // measureText() does: one table load instead of the glyph lookup and
+        // the kerning search, the same advances bit for bit. The loop state
+        // lives in locals: as members, every batch store (a float or uint16_t
+        // that may alias them) would send the pen, counts and scale back to
+        // memory per glyph
+        const GlyphHot* hot = glyphs.hot();
+        const uint8_t* pages = glyphs.pages();
+        const GlyphTable& table = font.atlas().glyphTable();
+        const AsciiMetrics& ascii = font.asciiMetrics();
+        const uint32_t ascii_end = ascii.usable() ? 0x80 : 0;
+        const float text_scale = scale;
+        const size_t capacity = target.capacity;
+        PageRange* ranges = target.ranges;
+        size_t range_count = target.range_count;
+        float pen = x;
+        uint16_t prev = prev_glyph;
+        size_t row = prev_row;
+        size_t glyph_count = written, pending = batched;
+        for (const Codepoint* c = first; c != last && !stopped; ++c) {
+            const uint32_t codepoint = (uint32_t)*c;
+            const bool ascii_pair = codepoint < 0x80 && row <= ASCII_ROW_START;
+            uint16_t glyph = ascii_pair ? ascii.glyph(codepoint) : table.lookupOrFallback(codepoint);
+            if (glyph == GLYPH_MISSING) {
+                stopped = true;
+                break;
+            }
+
+            const GlyphHot& metrics = hot[glyph];
+            if (GlyphStore::visible(metrics)) { //space and other blank glyphs have no quad
+                if (glyph_count == capacity) {
+                    stopped = true;
+                    break;
+                }
+                if (ranges) {
+                    uint32_t page = pages[glyph];
+                    if (range_count && ranges[range_count - 1].page == page) {
+                        ranges[range_count - 1].count += range_unit;
+                    } else {
+                        if (range_count == target.range_capacity) {
+                            stopped = true;
+                            break;
+                        }
+                        ranges[range_count++] = { page, (uint32_t)(glyph_count * range_unit), range_unit };
+                    }
+                }
+                batch_glyphs[pending] = glyph;
+                batch_pens[pending] = pen;
+                ++pending;
+                ++glyph_count;
+                if (pending == LAYOUT_BATCH) {
+                    written = glyph_count;
+                    batched = pending;
+                    flush();
+                    pending = 0;
+                }
+            }
+            if (target.pen_count < target.pen_capacity)
+                target.pens[target.pen_count++] = pen;
+            // advance and kerning are stored in atlas pixels
+            pen += (ascii_pair ? ascii.advance(row, codepoint) : glyphs.advance(prev, glyph)) * text_scale;
+            prev = glyph;
+            row = codepoint < ascii_end ? codepoint : ASCII_ROW_OTHER;
+        }
+        x = pen;
+        prev_glyph = prev;
+        prev_row = row;
+        written = glyph_count;
+        batched = pending;
+        target.range_count = range_count;
+        return !stopped;
+    }
+    // emit the pending batch; returns the glyphs written
+    // ------------------------------------------------------------------------
+    size_t finish()
+    {
+        flush();
+        if (target.pen_count < target.pen_capacity)
+            target.pens[target.pen_count++] = x;
+        return written;
+    }
+
+    float penX() const { return x; }
+
+private:
+    const Font& font;
+    const GlyphStore& glyphs;
+    LayoutTarget& target;
+    float x, y, scale, origin_x, plane_scale;
+    uint32_t range_unit;                // range entries per glyph: 4 vertices, 1 instance or 1 record
+    size_t written = 0;
+    uint16_t prev_glyph = GLYPH_MISSING;
+    size_t prev_row;                    // AsciiMetrics row of prev_glyph, see feed()
+    bool stopped = false;
+
+    uint16_t batch_glyphs[LAYOUT_BATCH];
+    float batch_pens[LAYOUT_BATCH];
+    size_t batched = 0;
+
+    void flush()
+    {
+        if (target.instances) {
+            emitInstanceBatch(glyphs, batch_glyphs, batch_pens, batched, y, plane_scale, target.style,
+                              target.instances + (written - batched));
+            batched = 0;
+            return;
+        }
+        if (target.pulled) {
+            emitPulledBatch(batch_glyphs, batch_pens, batched, origin_x, target.style, target.pulled + (written - batched));
+            batched = 0;
+            return;
+        }
+        if (target.compact) {
+            emitCompactBatch(glyphs, batch_glyphs, batch_pens, batched, y, plane_scale, origin_x, y, target.color,
+                             target.compact_stride, target.compact + (written - batched) * LAYOUT_QUAD_VERTICES * target.compact_stride);
+            batched = 0;
+            return;
+        }
+        emitQuadBatch<Simd>(glyphs, batch_glyphs, batch_pens, batched, y, plane_scale,
+                            target.vertices + (written - batched) * LAYOUT_QUAD_FLOATS);
+        batched = 0;
+    }
+};
+
+// the layout loop over any codepoint sequence
+template <typename Codepoint, bool Simd = true>
+inline size_t layoutCodepointRun(const Font& font, const Codepoint* first, const Codepoint* last,
+                                 float x, float y, float scale, LayoutTarget& target) {
+    LayoutCursor<Simd> cursor(font, x, y, scale, target);
+    cursor.feed(first, last);
+    return cursor.finish();
+}
+
+// lay out UTF-8 `text` with the pen starting at (x, y); returns the glyphs
+// written. The text is decoded LAYOUT_DECODE_CHUNK codepoints at a time into
+// a stack buffer
+// ------------------------------------------------------------------------
+inline size_t layoutText(const Font& font, std::string_view text, float x, float y, float scale, LayoutTarget& target) {
+    const unsigned char* in = reinterpret_cast<const unsigned char*>(text.data());
+    const unsigned char* end = in + text.size();
+    uint32_t codepoints[LAYOUT_DECODE_CHUNK];
+    LayoutCursor<> cursor(font, x, y, scale, target);
+    while (in < end) {
+        size_t count = utf8Decode(in, end, codepoints, LAYOUT_DECODE_CHUNK);
+        if (!cursor.feed(codepoints, codepoints + count))
+            break;
+    }
+    return cursor.finish();
+}
+
+inline size_t layoutText(const Font& font, const uint32_t* codepoints, size_t count, float x, float y, float scale, LayoutTarget& target) {
+    return layoutCodepointRun(font, codepoints, codepoints + count, x, y, scale, target);
+}
+
+struct TextMeasure {
+    float width = 0.0f;                 // pen advance of the widest line
+    float ink[4] = {};                  // union of the plane bounds: x0 y0 x1 y1; all 0 without visible glyphs
+    size_t line_count = 0;
+};
+
+// measure UTF-8 `text` without building quads: the pen advances and the
+// glyphs' plane bounds are exactly what layoutText() produces for the same
+// line. Lines end at '\n' and sit lineHeight apart (layoutText() itself
+// does not break lines); ink is relative to the pen origin on the first
+// baseline. Line widths are written to `lineWidths`, up to lineCapacity.
+// A scale <= 0 measures nothing (an empty TextMeasure), like layoutText().
+//
+// ASCII after ASCII is measured straight from the bytes with the font's
+// AsciiMetrics (one table load per advance, no glyph lookup or kerning
+// search); everything else is decoded and goes through the glyph store
+// ------------------------------------------------------------------------
+inline TextMeasure measureText(const Font& font, std::string_view text, float scale, float* lineWidths = nullptr, size_t lineCapacity = 0) {
+    if (!(scale > 0.0f))
+        return TextMeasure();
+    const GlyphStore& glyphs = font.glyphs();
+    const AsciiMetrics& ascii = font.asciiMetrics();
+    const float plane_scale = glyphs.planeUnit() * scale;
+    const float line_height = font.metrics().line_height * scale;
+    const size_t NON_ASCII = ASCII_ROW_START + 1;
+
+    TextMeasure measure;
+    float x = 0.0f, y = 0.0f;
+    uint16_t prev_glyph = GLYPH_MISSING;
+    size_t row = ascii.usable() ? ASCII_ROW_START : NON_ASCII;     // AsciiMetrics row of the previous glyph
+    auto endLine = [&]() {
+        if (measure.line_count < lineCapacity)
+            lineWidths[measure.line_count] = x;
+        if (x > measure.width)
+            measure.width = x;
+        ++measure.line_count;
+    };
+
+    // ink union as (min x0, min y0, max x1, max y1), grown by plane bounds
+#ifdef MSDF_GLYPH_STORE_SSE2
+    __m128 ink_min = _mm_set1_ps(HUGE_VALF);
+    __m128 ink_max = _mm_set1_ps(-HUGE_VALF);
+    const __m128 plane = _mm_set1_ps(plane_scale);
+    auto addInk = [&](__m128 bounds, float penX) {
+        __m128 corners = _mm_add_ps(_mm_mul_ps(bounds, plane), _mm_setr_ps(penX, y, penX, y));
+        ink_min = _mm_min_ps(corners, ink_min);
+        ink_max = _mm_max_ps(corners, ink_max);
+    };
+#else
+    float ink_min[4] = { HUGE_VALF, HUGE_VALF, HUGE_VALF, HUGE_VALF };
+    float ink_max[4] = { -HUGE_VALF, -HUGE_VALF, -HUGE_VALF, -HUGE_VALF };
+    auto addInk = [&](const float* bounds, float penX) {
+        const float pen[4] = { penX, y, penX, y };
+        for (int i = 0; i < 4; ++i) {
+            float corner = bounds[i] * plane_scale + pen[i];
+            ink_min[i] = std::min(ink_min[i], corner);
+            ink_max[i] = std::max(ink_max[i], corner);
+        }
+    };
+#endif
+
+    const unsigned char* in = reinterpret_cast<const unsigned char*>(text.data());
+    const unsigned char* end = in + text.size();
+    while (in < end) {
+        if (*in < 0x80 && *in != '\n' && row != NON_ASCII) {
+            // the ASCII run, with the pen in a register
+            float pen = x;
+            size_t previous = row;
+            for (; in < end; ++in) {
+                uint32_t c = *in;
+                if (c >= 0x80 || c == '\n')
+                    break;
+#ifdef MSDF_GLYPH_STORE_SSE2
+                addInk(_mm_load_ps(ascii.bounds(c)), pen);
+#else
+                addInk(ascii.bounds(c), pen);
+#endif
+                pen += ascii.advance(previous, c) * scale;
+                previous = c;
+            }
+            x = pen;
+            row = previous;
+            continue;
+        }
+        if (row < ASCII_ROW_START)
+            prev_glyph = ascii.glyph((uint32_t)row);
+
+        uint32_t codepoint = utf8DecodeOne(in, end);
+        if (codepoint == '\n') {
+            endLine();
+            x = 0.0f;
+            y -= line_height;
+            prev_glyph = GLYPH_MISSING;
+            row = ascii.usable() ? ASCII_ROW_START : NON_ASCII;
+            continue;
+        }
+        uint16_t glyph = font.glyphIndex(codepoint);
+        if (glyph == GLYPH_MISSING)
+            continue;
+        const GlyphHot& metrics = glyphs.hot()[glyph];
+        if (GlyphStore::visible(metrics)) {
+            float bounds[4] = { (float)metrics.pl, (float)metrics.pb, (float)metrics.pr, (float)metrics.pt };
+#ifdef MSDF_GLYPH_STORE_SSE2
+            addInk(_mm_loadu_ps(bounds), x);
+#else
+            addInk(bounds, x);
+#endif
+        }
+        x += glyphs.advance(prev_glyph, glyph) * scale;
+        prev_glyph = glyph;
+        row = (codepoint < 0x80 && ascii.usable()) ? codepoint : NON_ASCII;
+    }
+    endLine();
+
+    float low[4], high[4];
+#ifdef MSDF_GLYPH_STORE_SSE2
+    _mm_storeu_ps(low, ink_min);
+    _mm_storeu_ps(high, ink_max);
+#else
+    memcpy(low, ink_min, sizeof(low));
+    memcpy(high, ink_max, sizeof(high));
+#endif
+    if (low[0] <= high[2]) {
+        measure.ink[0] = low[0];
+        measure.ink[1] = low[1];
+        measure.ink[2] = high[2];
+        measure.ink[3] = high[3];
+    }
+    return measure;
+}
+
+#endif
@@ -0,0 +1,278 @@
+#ifndef MSDF_TEXT_VIEW_H
+#define MSDF_TEXT_VIEW_H
+
+// Virtualized view of a long line-oriented document (a log buffer). Every
+// line is lineHeight() tall, so the lines under the viewport follow from the
+// scroll position alone and nothing off screen is ever measured. Only the
+// lines intersecting the viewport plus a prefetch margin above and below are
+// laid out; they live in a ring of fixed slots (line i in slot i % slots),
+// so scrolling by n lines lays out the n lines that enter, and a jump lays
+// out one viewport. Layout, memory and the vertices emitted per frame depend
+// on the viewport size only, not on the document size.
+//
+// A slot holds its line in line-local coordinates (pen at x = 0, top of the
+// line at y = 0); emit() places the visible lines for the current scroll.
+// Lines are cut at the view width with a trailing "..." (ellipsizeText())
+// and never hold more than `columns` glyphs.
+
+#include <msdf_advance_index.h>
+#include <msdf_atlas_pages.h>
+#include <msdf_font.h>
+#include <msdf_text_layout.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+const size_t VIEW_COLUMNS = 256;        // glyphs a line slot holds
+const size_t VIEW_NO_LINE = (size_t)-1;
+
+class VirtualTextView
+{
+public:
+    // prefetch: lines laid out ahead above and below the viewport
+    VirtualTextView(const Font& font, float scale, size_t columns = VIEW_COLUMNS, size_t prefetch = 8)
+        : font(font), scale(scale), columns(columns), prefetch(prefetch) {}
+
+    VirtualTextView(const VirtualTextView&) = delete;
+    VirtualTextView& operator=(const VirtualTextView&) = delete;
+
+    // replace the document; lines end at '\n'
+    // ------------------------------------------------------------------------
+    void setText(std::string_view text)
+    {
+        document.assign(text.data(), text.size());
+        line_starts.assign(1, 0);
+        for (size_t i = 0; i < document.size(); ++i)
+            if (document[i] == '\n')
+                line_starts.push_back(i + 1);
+        std::fill(slot_lines.begin(), slot_lines.end(), VIEW_NO_LINE);
+    }
+    // append one line at the end of the document (log tailing); it is laid
+    // out by the next update() if it is in the resident window
+    // ------------------------------------------------------------------------
+    void appendLine(std::string_view line)
+    {
+        document += '\n';
+        document.append(line.data(), line.size());
+        line_starts.push_back(document.size() - line.size());
+    }
+
+    // the viewport: `top` pixels scrolled down from the top of line 0,
+    // `height` pixels tall; width 0 does not cut lines (columns still does)
+    // ------------------------------------------------------------------------
+    void setViewport(double top, float height, float width = 0.0f)
+    {
+        view_top = std::max(0.0, top);
+        view_height = height;
+        if (width != view_width) {
+            view_width = width;
+            std::fill(slot_lines.begin(), slot_lines.end(), VIEW_NO_LINE);
+        }
+        size_t slots = (size_t)std::ceil(height / lineHeight()) + 2 * prefetch + 2;
+        if (slots != slot_lines.size()) {
+            slot_lines.assign(slots, VIEW_NO_LINE);
+            slot_glyphs.assign(slots, 0);
+            slot_ranges.assign(slots, 0);
+            vertices.assign(slots * columns * LAYOUT_QUAD_FLOATS, 0.0f);
+            ranges.assign(slots * columns, PageRange());
+        }
+    }
+
+    // lay out the resident lines that are not in their slot yet; returns how many
+    // ------------------------------------------------------------------------
+    size_t update()
+    {
+        size_t first, last;
+        residentLines(first, last);
+        size_t laid = 0;
+        for (size_t line = first; line < last; ++line) {
+            size_t slot = line % slot_lines.size();
+            if (slot_lines[slot] == line)
+                continue;
+            layoutLine(line, slot);
+            ++laid;
+        }
+        relaid_lines += laid;
+        return laid;
+    }
+
+    // write the lines intersecting the viewport, its top left corner at
+    // (x, y), into a quad target (e.g. a mapped stream region, only written);
+    // ranges start at target.vertices and are merged where consecutive lines
+    // share a page. Lines not laid out yet (no update() since they became
+    // visible) are skipped; stops before the first line that does not fit.
+    // Returns the quads written
+    // ------------------------------------------------------------------------
+    size_t emit(float x, float y, LayoutTarget& target) const
+    {
+        target.range_count = 0;
+        size_t first, last, written = 0;
+        if (!visibleLines(first, last))
+            return 0;
+        const double line_height = lineHeight();
+        for (size_t line = first; line < last; ++line) {
+            size_t slot = line % slot_lines.size();
+            if (slot_lines[slot] != line)
+                continue;
+            size_t quads = slot_glyphs[slot];
+            if (written + quads > target.capacity ||
+                (target.ranges && target.range_count + slot_ranges[slot] > target.range_capacity))
+                break;
+            float line_y = y - (float)(line * line_height - view_top);
+            uint32_t base = (uint32_t)(written * LAYOUT_QUAD_VERTICES);
+            const float* source = &vertices[slot * columns * LAYOUT_QUAD_FLOATS];
+            float* out = target.vertices + written * LAYOUT_QUAD_FLOATS;
+            for (size_t v = 0; v < quads * LAYOUT_QUAD_FLOATS; v += LAYOUT_VERTEX_FLOATS) {
+                out[v + 0] = source[v + 0] + x;
+                out[v + 1] = source[v + 1] + line_y;
+                memcpy(out + v + 2, source + v + 2, (LAYOUT_VERTEX_FLOATS - 2) * sizeof(float));
+            }
+            written += quads;
+            if (target.ranges == nullptr)
+                continue;
+            for (size_t r = 0; r < slot_ranges[slot]; ++r) {
+                const PageRange& range = ranges[slot * columns + r];
+                PageRange* previous = target.range_count ? &target.ranges[target.range_count - 1] : nullptr;
+                if (previous && previous->page == range.page && previous->first + previous->count == base + range.first)
+                    previous->count += range.count;
+                else
+                    target.ranges[target.range_count++] = { range.page, base + range.first, range.count };
+            }
+        }
+        return written;
+    }
+    // append the visible lines to a vertex stream; page ranges are appended
+    // with the base vertex applied
+    // ------------------------------------------------------------------------
+    void emit(float x, float y, std::vector<float>& out, std::vector<PageRange>* outRanges = nullptr) const
+    {
+        uint32_t base = (uint32_t)(out.size() / LAYOUT_VERTEX_FLOATS);
+        size_t first = out.size();
+        size_t first_range = outRanges ? outRanges->size() : 0;
+        out.resize(first + visibleQuads() * LAYOUT_QUAD_FLOATS);
+        if (outRanges)
+            outRanges->resize(first_range + visibleRanges());
+        LayoutTarget target(out.data() + first, (out.size() - first) / LAYOUT_QUAD_FLOATS,
+                            outRanges ? outRanges->data() + first_range : nullptr,
+                            outRanges ? outRanges->size() - first_range : 0);
+        size_t quads = emit(x, y, target);
+        out.resize(first + quads * LAYOUT_QUAD_FLOATS);
+        if (outRanges) {
+            outRanges->resize(first_range + target.range_count);
+            for (size_t r = first_range; r < outRanges->size(); ++r)
+                (*outRanges)[r].first += base;
+        }
+    }
+    // quads and (at most) page ranges emit() writes for the current viewport
+    // ------------------------------------------------------------------------
+    size_t visibleQuads() const
+    {
+        size_t first, last, total = 0;
+        if (visibleLines(first, last))
+            for (size_t line = first; line < last; ++line)
+                if (slot_lines[line % slot_lines.size()] == line)
+                    total += slot_glyphs[line % slot_lines.size()];
+        return total;
+    }
+    size_t visibleRanges() const
+    {
+        size_t first, last, total = 0;
+        if (visibleLines(first, last))
+            for (size_t line = first; line < last; ++line)
+                if (slot_lines[line % slot_lines.size()] == line)
+                    total += slot_ranges[line % slot_lines.size()];
+        return total;
+    }
+
+    size_t lineCount() const { return line_starts.size(); }
+    std::string_view line(size_t index) const
+    {
+        size_t begin = line_starts[index];
+        size_t end = index + 1 < line_starts.size() ? line_starts[index + 1] - 1 : document.size();
+        return std::string_view(document).substr(begin, end - begin);
+    }
+    float lineHeight() const { return font.metrics().line_height * scale; }
+    double contentHeight() const { return (double)lineCount() * lineHeight(); }
+    double top() const { return view_top; }
+    size_t slotCount() const { return slot_lines.size(); }
+    size_t relaidLines() const { return relaid_lines; }
+
+    // the lines kept laid out: the viewport plus the prefetch margin
+    void residentLines(size_t& first, size_t& last) const
+    {
+        size_t visible = (size_t)(view_top / lineHeight());
+        first = visible > prefetch ? visible - prefetch : 0;
+        last = std::min(first + slot_lines.size(), lineCount());
+        first = std::min(first, last);
+    }
+
+private:
+    const Font& font;
+    float scale;
+    size_t columns, prefetch;
+    std::string document;
+    std::vector<size_t> line_starts{ 0 };
+    double view_top = 0.0;
+    float view_height = 0.0f, view_width = 0.0f;
+
+    std::vector<size_t> slot_lines;     // line held by each slot, VIEW_NO_LINE when empty
+    std::vector<size_t> slot_glyphs;
+    std::vector<size_t> slot_ranges;
+    std::vector<float> vertices;        // `columns` quads per slot
+    std::vector<PageRange> ranges;      // `columns` ranges per slot, relative to the slot
+    size_t relaid_lines = 0;
+
+    // lines [first, last) intersecting the viewport; false before setViewport()
+    bool visibleLines(size_t& first, size_t& last) const
+    {
+        if (slot_lines.empty())
+            return false;
+        const double line_height = lineHeight();
+        first = std::min((size_t)(view_top / line_height), lineCount());
+        last = std::min((size_t)std::ceil((view_top + view_height) / line_height), lineCount());
+        return true;
+    }
+
+    void layoutLine(size_t line, size_t slot)
+    {
+        std::string_view text = this->line(line);
+        LayoutTarget target(&vertices[slot * columns * LAYOUT_QUAD_FLOATS], columns, &ranges[slot * columns], columns);
+        float baseline = -font.metrics().ascender * scale;
+        size_t glyphs;
+        Ellipsis cut;
+        if (view_width > 0.0f)
+            cut = ellipsizeText(font, text, scale, view_width);
+        if (cut.truncated) {
+            glyphs = layoutText(font, text.substr(0, cut.bytes), 0.0f, baseline, scale, target);
+            size_t range_count = target.range_count;
+            LayoutTarget mark(target.vertices + glyphs * LAYOUT_QUAD_FLOATS, columns - glyphs,
+                              target.ranges + range_count, columns - range_count);
+            float mark_x = cut.width - ellipsisWidth(font, scale);
+            size_t marked = layoutText(font, ellipsisMark(font), mark_x, baseline, scale, mark);
+            for (size_t r = 0; r < mark.range_count; ++r) {
+                PageRange range = mark.ranges[r];
+                range.first += (uint32_t)(glyphs * LAYOUT_QUAD_VERTICES);
+                PageRange* previous = range_count ? &target.ranges[range_count - 1] : nullptr;
+                if (previous && previous->page == range.page)
+                    previous->count += range.count;
+                else
+                    target.ranges[range_count++] = range;
+            }
+            glyphs += marked;
+            target.range_count = range_count;
+        } else {
+            glyphs = layoutText(font, text, 0.0f, baseline, scale, target);
+        }
+        slot_lines[slot] = line;
+        slot_glyphs[slot] = glyphs;
+        slot_ranges[slot] = target.range_count;
+    }
+};
+
+#endif
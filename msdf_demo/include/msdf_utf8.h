@@ -0,0 +1,168 @@
+#ifndef MSDF_UTF8_H
+#define MSDF_UTF8_H
+
+// UTF-8 to codepoint decoding in front of layout. Runs of ASCII are checked
+// 16 (SSE2) or 32 (AVX2) bytes at a time and widened to codepoints without a
+// per-byte branch; everything else goes through the validating scalar
+// decoder. Malformed input (stray continuation bytes, overlong forms,
+// surrogates, values above U+10FFFF, truncated sequences) decodes to U+FFFD
+// one byte at a time, so a bad byte never swallows the text after it.
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define MSDF_UTF8_AVX2 1
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MSDF_UTF8_SSE2 1
+#endif
+
+const uint32_t UTF8_REPLACEMENT = 0xFFFD;
+const size_t UTF8_SCALAR_SPAN = 32;    // bytes decoded one sequence at a time after a non-ASCII block
+
+// decode one sequence at `in` (in < end), advancing `in`
+inline uint32_t utf8DecodeOne(const unsigned char*& in, const unsigned char* end) {
+    unsigned char lead = *in;
+    if (lead < 0x80) {
+        ++in;
+        return lead;
+    }
+
+    int length;
+    uint32_t codepoint;
+    unsigned char low = 0x80, high = 0xBF;    // valid range of the second byte
+    if (lead >= 0xC2 && lead <= 0xDF) {
+        length = 2;
+        codepoint = lead & 0x1F;
+    } else if (lead >= 0xE0 && lead <= 0xEF) {
+        length = 3;
+        codepoint = lead & 0x0F;
+        if (lead == 0xE0) low = 0xA0;          // overlong
+        if (lead == 0xED) high = 0x9F;         // surrogates
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+        length = 4;
+        codepoint = lead & 0x07;
+        if (lead == 0xF0) low = 0x90;          // overlong
+        if (lead == 0xF4) high = 0x8F;         // above U+10FFFF
+    } else {
+        ++in;
+        return UTF8_REPLACEMENT;
+    }
+
+    if (end - in < length || in[1] < low || in[1] > high) {
+        ++in;
+        return UTF8_REPLACEMENT;
+    }
+    for (int i = 2; i < length; ++i) {
+        if ((in[i] & 0xC0) != 0x80) {
+            ++in;
+            return UTF8_REPLACEMENT;
+        }
+    }
+    for (int i = 1; i < length; ++i)
+        codepoint = (codepoint << 6) | (in[i] & 0x3F);
+    in += length;
+    return codepoint;
+}
+
+inline int utf8LowestBit(uint32_t mask) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return (int)index;
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+// decode from `in` until `end` or until `capacity` codepoints are written;
+// advances `in` past whole sequences only and returns the codepoints written.
+// AsciiFastPath = false decodes everything one sequence at a time
+template <bool AsciiFastPath = true>
+inline size_t utf8Decode(const unsigned char*& in, const unsigned char* end, uint32_t* out, size_t capacity) {
+    uint32_t* const first = out;
+    uint32_t* const out_end = out + capacity;
+    const unsigned char* next_block = in;
+    while (in < end && out < out_end) {
+        if (AsciiFastPath && in >= next_block) {
+            // each block is widened whole, then only its leading ASCII bytes
+            // are kept: mixed text still moves a word at a time
+#ifdef MSDF_UTF8_AVX2
+            while (end - in >= 32 && out_end - out >= 32) {
+                __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in));
+                for (int i = 0; i < 32; i += 8)
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i),
+                                        _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(in + i))));
+                uint32_t mask = (uint32_t)_mm256_movemask_epi8(bytes);
+                int ascii = mask ? utf8LowestBit(mask) : 32;
+                in += ascii;
+                out += ascii;
+                if (mask)
+                    break;
+            }
+#endif
+#ifdef MSDF_UTF8_SSE2
+            while (end - in >= 16 && out_end - out >= 16) {
+                __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+                const __m128i zero = _mm_setzero_si128();
+                __m128i low = _mm_unpacklo_epi8(bytes, zero);
+                __m128i high = _mm_unpackhi_epi8(bytes, zero);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 0), _mm_unpacklo_epi16(low, zero));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 4), _mm_unpackhi_epi16(low, zero));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 8), _mm_unpacklo_epi16(high, zero));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 12), _mm_unpackhi_epi16(high, zero));
+                uint32_t mask = (uint32_t)_mm_movemask_epi8(bytes);
+                int ascii = mask ? utf8LowestBit(mask) : 16;
+                in += ascii;
+                out += ascii;
+                if (mask)
+                    break;
+            }
+#endif
+            if (in == end || out == out_end)
+                break;
+            // non-ASCII text: the next UTF8_SCALAR_SPAN bytes go through the
+            // scalar decoder, a block check per character costs more than it saves
+            next_block = in + UTF8_SCALAR_SPAN;
+        }
+        *out++ = utf8DecodeOne(in, end);
+    }
+    return (size_t)(out - first);
+}
+
+inline size_t utf8Decode(std::string_view text, uint32_t* out, size_t capacity) {
+    const unsigned char* in = reinterpret_cast<const unsigned char*>(text.data());
+    return utf8Decode(in, in + text.size(), out, capacity);
+}
+
+// append the UTF-8 form of a codepoint
+inline void utf8Append(std::string& text, uint32_t codepoint) {
+    if (codepoint > 0x10FFFF || (codepoint >= 0xD800 && codepoint <= 0xDFFF))
+        codepoint = UTF8_REPLACEMENT;
+    if (codepoint < 0x80) {
+        text += (char)codepoint;
+    } else if (codepoint < 0x800) {
+        text += (char)(0xC0 | (codepoint >> 6));
+        text += (char)(0x80 | (codepoint & 0x3F));
+    } else if (codepoint < 0x10000) {
+        text += (char)(0xE0 | (codepoint >> 12));
+        text += (char)(0x80 | ((codepoint >> 6) & 0x3F));
+        text += (char)(0x80 | (codepoint & 0x3F));
+    } else {
+        text += (char)(0xF0 | (codepoint >> 18));
+        text += (char)(0x80 | ((codepoint >> 12) & 0x3F));
+        text += (char)(0x80 | ((codepoint >> 6) & 0x3F));
+        text += (char)(0x80 | (codepoint & 0x3F));
+    }
+}
+
+#endif
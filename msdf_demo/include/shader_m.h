@@ -9,6 +9,14 @@
 #include <sstream>
 #include <iostream>
 
+// vertex/fragment source code, read from disk without touching GL so it can
+// be loaded on a worker thread and compiled later on the GL thread
+struct ShaderSource
+{
+    std::string vertexCode;
+    std::string fragmentCode;
+};
+
 class Shader
 {
 public:
@@ -17,9 +25,20 @@ public:
     // ------------------------------------------------------------------------
     Shader(const char* vertexPath, const char* fragmentPath)
     {
-        // 1. retrieve the vertex/fragment source code from filePath
-        std::string vertexCode;
-        std::string fragmentCode;
+        ShaderSource source = readSource(vertexPath, fragmentPath);
+        compile(source.vertexCode.c_str(), source.fragmentCode.c_str());
+    }
+    // constructor compiling already loaded source code (needs the GL context)
+    // ------------------------------------------------------------------------
+    explicit Shader(const ShaderSource& source)
+    {
+        compile(source.vertexCode.c_str(), source.fragmentCode.c_str());
+    }
+    // retrieve the vertex/fragment source code from filePath; no GL calls
+    // ------------------------------------------------------------------------
+    static ShaderSource readSource(const char* vertexPath, const char* fragmentPath)
+    {
+        ShaderSource source;
         std::ifstream vShaderFile;
         std::ifstream fShaderFile;
         // ensure ifstream objects can throw exceptions:
@@ -38,37 +57,14 @@ public:
             vShaderFile.close();
             fShaderFile.close();
             // convert stream into string
-            vertexCode = vShaderStream.str();
-            fragmentCode = fShaderStream.str();			
+            source.vertexCode = vShaderStream.str();
+            source.fragmentCode = fShaderStream.str();			
         }
         catch (std::ifstream::failure& e)
         {
             std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << e.what() << std::endl;
         }
-        const char* vShaderCode = vertexCode.c_str();
-        const char * fShaderCode = fragmentCode.c_str();
-        // 2. compile shaders
-        unsigned int vertex, fragment;
-        // vertex shader
-        vertex = glCreateShader(GL_VERTEX_SHADER);
-        glShaderSource(vertex, 1, &vShaderCode, NULL);
-        glCompileShader(vertex);
-        checkCompileErrors(vertex, "VERTEX");
-        // fragment Shader
-        fragment = glCreateShader(GL_FRAGMENT_SHADER);
-        glShaderSource(fragment, 1, &fShaderCode, NULL);
-        glCompileShader(fragment);
-        checkCompileErrors(fragment, "FRAGMENT");
-        // shader Program
-        ID = glCreateProgram();
-        glAttachShader(ID, vertex);
-        glAttachShader(ID, fragment);
-        glLinkProgram(ID);
-        checkCompileErrors(ID, "PROGRAM");
-        // delete the shaders as they're linked into our program now and no longer necessary
-        glDeleteShader(vertex);
-        glDeleteShader(fragment);
-
+        return source;
     }
     // activate the shader
     // ------------------------------------------------------------------------
@@ -136,6 +132,31 @@ public:
     }
 
 private:
+    // compile shaders and link the program
+    // ------------------------------------------------------------------------
+    void compile(const char* vShaderCode, const char* fShaderCode)
+    {
+        unsigned int vertex, fragment;
+        // vertex shader
+        vertex = glCreateShader(GL_VERTEX_SHADER);
+        glShaderSource(vertex, 1, &vShaderCode, NULL);
+        glCompileShader(vertex);
+        checkCompileErrors(vertex, "VERTEX");
+        // fragment Shader
+        fragment = glCreateShader(GL_FRAGMENT_SHADER);
+        glShaderSource(fragment, 1, &fShaderCode, NULL);
+        glCompileShader(fragment);
+        checkCompileErrors(fragment, "FRAGMENT");
+        // shader Program
+        ID = glCreateProgram();
+        glAttachShader(ID, vertex);
+        glAttachShader(ID, fragment);
+        glLinkProgram(ID);
+        checkCompileErrors(ID, "PROGRAM");
+        // delete the shaders as they're linked into our program now and no longer necessary
+        glDeleteShader(vertex);
+        glDeleteShader(fragment);
+    }
     // utility function for checking shader compilation/linking errors.
     // ------------------------------------------------------------------------
     void checkCompileErrors(GLuint shader, std::string type)
@@ -14,6 +14,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include "stb_image.h"
+#include <msdf_texel_cache.h>
 
 #include <fstream>
 #include <map>
@@ -78,13 +79,11 @@ GLuint loadTexture(const char* path) {
     GLuint textureID;
     glGenTextures(1, &textureID);
 
-    stbi_set_flip_vertically_on_load(true);
-    int width, height, nrChannels;
-    unsigned char* data = stbi_load(path, &width, &height, &nrChannels, 0);
-    if (data) {
-        GLenum format = (nrChannels == 4) ? GL_RGBA : (nrChannels == 3) ? GL_RGB : GL_RED;
+    TexelImage image = loadTexels(path, true);
+    if (image.pixels) {
+        GLenum format = (image.channels == 4) ? GL_RGBA : (image.channels == 3) ? GL_RGB : GL_RED;
         glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+        glTexImage2D(GL_TEXTURE_2D, 0, format, image.width, image.height, 0, format, GL_UNSIGNED_BYTE, image.pixels);
         //glGenerateMipmap(GL_TEXTURE_2D);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
@@ -94,7 +93,7 @@ GLuint loadTexture(const char* path) {
     else {
         std::cerr << "Failed to load texture" << std::endl;
     }
-    stbi_image_free(data);
+    image.release();
 
     return textureID;
 }
@@ -10,25 +10,29 @@
 
 #include <iostream>
 #include <fstream>
-#include <map>
-#include <nlohmann/json.hpp>
-#include <shader_m.h>
-
-using json = nlohmann::json;
-
-struct GlyphData {
-
-    char character;
-    float x, y, width, height;
-    float advance;
-    float pl, pb, pr, pt;
-};
-
-struct AtlasMetric {
-    float fontSize;
-    float width;
-    float height;
-};
+#include <cstring>
+#include <msdf_atlas_bin.h>
+#include <msdf_bench.h>
+#include <msdf_startup.h>
+#include <msdf_texel_cache.h>
+#include <msdf_atlas_pages.h>
+#include <msdf_compact_vertices.h>
+#include <msdf_font.h>
+#include <msdf_glyph_instances.h>
+#include <msdf_glyph_pulling.h>
+#include <msdf_paragraph.h>
+#include <msdf_quad_indices.h>
+#include <msdf_run_cache.h>
+#include <msdf_stream_buffer.h>
+#include <msdf_text_layout.h>
+#include <msdf_text_view.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstdio>
+#include <future>
+#include <string_view>
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void processInput(GLFWwindow *window);
@@ -37,101 +41,54 @@ void processInput(GLFWwindow *window);
 const unsigned int SCR_WIDTH = 1024;
 const unsigned int SCR_HEIGHT = 1024;
 
-std::map<char, GlyphData> glyphs;
-AtlasMetric atlas_metric;
-float kerning_table[256][256];
-
-void loadGlyphData(const std::string& jsonPath) {
-
-    std::ifstream inputFile(jsonPath);
-    if (inputFile.is_open()) {
-        json metadata;
-        inputFile >> metadata;
-
-        atlas_metric.fontSize = metadata["atlas"]["size"].get<float>();
-        atlas_metric.height = metadata["atlas"]["height"].get<float>();
-        atlas_metric.width = metadata["atlas"]["width"].get<float>();
-
-        for (auto& glyph : metadata["glyphs"]) {
-            char character = glyph["unicode"].get<char>();
-            if (glyph.contains("atlasBounds") && glyph.contains("planeBounds") ){
-                GlyphData glyphData = {
-                character,
-                glyph["atlasBounds"]["left"],
-                glyph["atlasBounds"]["bottom"],
-                glyph["atlasBounds"]["right"].get<float>() - glyph["atlasBounds"]["left"].get<float>(),
-                glyph["atlasBounds"]["top"].get<float>() - glyph["atlasBounds"]["bottom"].get<float>(),
-                glyph["advance"],
-                glyph["planeBounds"]["left"],
-                glyph["planeBounds"]["bottom"],
-                glyph["planeBounds"]["right"],
-                glyph["planeBounds"]["top"],
-                };
-                glyphs[character] = glyphData;
-            }
-            else {
-                GlyphData data;
-                data.advance = glyph["advance"];
-                glyphs[character] = data;
-            }
-
-        }
-
-        memset( kerning_table, 0.0f, sizeof( kerning_table ) );
-        for (auto& kerning : metadata["kerning"]) {
-            int unicode1 = kerning["unicode1"].get<int>();
-            int unicode2 = kerning["unicode2"].get<int>();
-
-            float kerning_val = kerning["advance"].get<float>();
-            kerning_table[unicode1][unicode2] = kerning_val;
-        }
-    }
-}
+FontRegistry fonts;
+GlyphRunCache runs;     // render thread
+FrameArena frameArena;  // render thread, reset every frame
+float panelWidth = SCR_WIDTH * 0.4f;    // wrap width of the alarm panel, follows the framebuffer
+
+// a line of text in one font, laid out on the font's startup worker
+struct Label {
+    std::string text;
+    float x;
+    float y;
+    float scale;
+    std::vector<float> vertices;    // startup layout, tells the worker which pages to load
+    std::vector<PageRange> ranges;
+};
 
 
 // render line of text
 // -------------------
-std::vector<float> generateVertexData(std::string text, float x, float y, float scale ) {
-
-    std::vector<float> vertices;
-    // iterate through all characters
-    std::string::const_iterator c;
-    float font_size = atlas_metric.fontSize;
-    float atlas_w = atlas_metric.width;
-    float atlas_h = atlas_metric.height;
-    char prev_ch = 0;
-
-    for (c = text.begin(); c != text.end(); c++) {
-        const GlyphData& glyph = glyphs[*c];
-
-        if ((*c) != 32) { //if it is not the space character
-            float tx0 = glyph.x / atlas_w;
-            float ty0 = glyph.y / atlas_h;
-            float tx1 = (glyph.x + glyph.width) / atlas_w;
-            float ty1 = (glyph.y + glyph.height) / atlas_h;
-
-            float w = glyph.width * scale;
-            float h = glyph.height * scale;
-
-            float  x0 = x + font_size * glyph.pl * scale;
-            float  x1 = x + font_size * glyph.pr * scale;
-            float  y0 = y + font_size * glyph.pb * scale;
-            float  y1 = y + font_size * glyph.pt * scale;
-
-            vertices.insert(vertices.end(), {
-                //Position                         //TexCoords
-                x1, y1, 0.0f,  1.0f, 0.0f, 0.0f,   tx1, ty1,
-                x1, y0, 0.0f,  0.0f, 1.0f, 0.0f,   tx1, ty0,
-                x0, y1, 0.0f,  1.0f, 1.0f, 0.0f,   tx0, ty1,
-
-                x1, y0, 0.0f,  0.0f, 1.0f, 0.0f,   tx1, ty0,
-                x0, y0, 0.0f,  0.0f, 0.0f, 1.0f,   tx0, ty0,
-                x0, y1, 0.0f,  1.0f, 1.0f, 0.0f,   tx0, ty1
-            });
+// convenience wrapper over layoutText() for startup and run cache misses;
+// when `ranges` is given, the quads are grouped by atlas page and one range
+// per referenced page is returned
+std::vector<float> generateVertexData(const Font& font, std::string_view text, float x, float y, float scale, std::vector<PageRange>* ranges = nullptr ) {
+
+    std::vector<float> vertices(text.size() * LAYOUT_QUAD_FLOATS);
+    std::vector<PageRange> runs(text.size());
+    LayoutTarget target(vertices.data(), text.size(), runs.data(), runs.size());
+    size_t glyphs = layoutText(font, text, x, y, scale, target);
+    vertices.resize(glyphs * LAYOUT_QUAD_FLOATS);
+    runs.resize(target.range_count);
+
+    if (ranges) {
+        // stable sort of the page runs by page; single-page text keeps its order
+        std::vector<PageRange> sorted = runs;
+        std::stable_sort(sorted.begin(), sorted.end(), [](const PageRange& a, const PageRange& b) { return a.page < b.page; });
+
+        ranges->clear();
+        std::vector<float> grouped;
+        grouped.reserve(vertices.size());
+        for (const PageRange& run : sorted) {
+            uint32_t first = (uint32_t)(grouped.size() / LAYOUT_VERTEX_FLOATS);
+            grouped.insert(grouped.end(), vertices.begin() + run.first * LAYOUT_VERTEX_FLOATS,
+                           vertices.begin() + (run.first + run.count) * LAYOUT_VERTEX_FLOATS);
+            if (!ranges->empty() && ranges->back().page == run.page)
+                ranges->back().count += run.count;
+            else
+                ranges->push_back({ run.page, first, run.count });
         }
-        float kerning = kerning_table[prev_ch][*c];
-        x += (font_size * (glyph.advance + kerning)) * scale; // bitshift by 6 to get value in pixels (2^6 = 64 (divide amount of 1/64th pixels by 64 to get amount of pixels))
-        prev_ch = *c;
+        vertices.swap(grouped);
     }
 
     return vertices;
@@ -162,35 +119,301 @@ std::vector<float> generateVertexData(std::string text, float x, float y, float
     return vertices;
 }*/
 
+// smoke test of vertex pulling
+// ----------------------------
+// draws one label as indexed quads and as pulled glyph records, with the
+// demo's shaders, into an offscreen framebuffer and compares the pixels;
+// the GL context must be current. 0 when the two paths match
+int runSmokeTest(Font& font)
+{
+    std::cout << "GL_RENDERER: " << glGetString(GL_RENDERER) << ", GL_VERSION: " << glGetString(GL_VERSION) << std::endl;
+
+    const int width = 512, height = 128;
+    const std::string text = "Pump 3: 1013 hPa WARNING {AV To 12:00.5}";
+    const float x = 10.3f, y = 50.7f, scale = 0.4f;
+    const size_t maxDifferingPixels = 16;   // edge pixels may round differently, positions are computed on the GPU
+
+    Shader quadShader("shaders/4.2.texture.vs", "shaders/msdf_text_glow4.frag");
+    Shader pulledShader("shaders/4.2.texture_pulled.vs", "shaders/msdf_text_glow4.frag");
+    GLint quadLinked = 0, pulledLinked = 0;
+    glGetProgramiv(quadShader.ID, GL_LINK_STATUS, &quadLinked);
+    glGetProgramiv(pulledShader.ID, GL_LINK_STATUS, &pulledLinked);
+    if (!quadLinked || !pulledLinked)
+    {
+        std::cout << "ERROR::SMOKE::SHADER_NOT_LINKED" << std::endl;
+        return 1;
+    }
+    glm::mat4 projection = glm::ortho(0.0f, (float)width, 0.0f, (float)height);
+    const float styleColors[INSTANCE_STYLES * 3] = { 1.0f, 1.0f, 1.0f };
+    for (const Shader* shader : { &quadShader, &pulledShader })
+    {
+        shader->use();
+        glUniformMatrix4fv(glGetUniformLocation(shader->ID, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+        glUniform1i(glGetUniformLocation(shader->ID, "u_msdf"), 0);
+        glUniform4f(glGetUniformLocation(shader->ID, "fgColor"), 1.0f, 1.0f, 1.0f, 1.0f);
+        glUniform4f(glGetUniformLocation(shader->ID, "outlineColor"), 1.0f, 0.0f, 0.0f, 1.0f);
+    }
+    glUniform3fv(glGetUniformLocation(pulledShader.ID, "styleColors"), (GLsizei)INSTANCE_STYLES, styleColors);
+
+    // offscreen target, read back after each path
+    unsigned int fbo, colorTexture;
+    glGenTextures(1, &colorTexture);
+    glBindTexture(GL_TEXTURE_2D, colorTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture, 0);
+    glViewport(0, 0, width, height);
+    std::vector<unsigned char> quadPixels(width * height * 4), pulledPixels(width * height * 4);
+    AtlasPages& pages = font.pages();
+
+    // reference: quads laid out on the CPU
+    std::vector<PageRange> quadRanges;
+    std::vector<float> vertices = generateVertexData(font, text, x, y, scale, &quadRanges);
+    unsigned int VAO, VBO;
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &VBO);
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
+    glEnableVertexAttribArray(2);
+    QuadIndexBuffer quadIndices;
+    quadIndices.create(text.size());
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    quadShader.use();
+    for (const PageRange& range : quadRanges)
+    {
+        if (!pages.require(range.page))
+            continue;
+        glBindTexture(GL_TEXTURE_2D, pages.texture(range.page));
+        quadIndices.draw(range);
+    }
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, quadPixels.data());
+
+    // pulled: records at the layout origin, placed by the draw
+    std::vector<PulledGlyph> records(text.size());
+    std::vector<PageRange> pulledRanges(text.size());
+    LayoutTarget target = LayoutTarget::pulledGlyphs(records.data(), records.size(), pulledRanges.data(), pulledRanges.size());
+    size_t glyphs = layoutText(font, text, 0.0f, 0.0f, scale, target);
+    GlyphTableBuffer glyphTable;
+    PulledGlyphBuffer pulledGlyphs;
+    bool tableCreated = glyphTable.create(font.glyphs());
+    pulledGlyphs.create();
+    glClear(GL_COLOR_BUFFER_BIT);
+    if (tableCreated)
+    {
+        pulledShader.use();
+        pulledGlyphs.upload(records.data(), glyphs);
+        pulledGlyphs.bind(pulledShader.ID, glyphTable);
+        pulledGlyphOrigin(pulledShader.ID, glyphTable, x, y, scale);
+        for (size_t i = 0; i < target.range_count; ++i)
+        {
+            if (!pages.require(target.ranges[i].page))
+                continue;
+            glBindTexture(GL_TEXTURE_2D, pages.texture(target.ranges[i].page));
+            pulledGlyphs.draw(target.ranges[i]);
+        }
+    }
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pulledPixels.data());
+    GLenum error = glGetError();
+
+    size_t litPixels = 0, differingPixels = 0;
+    int maxDifference = 0;
+    for (size_t i = 0; i < quadPixels.size(); i += 4)
+    {
+        litPixels += quadPixels[i + 3] != 0;
+        int difference = 0;
+        for (size_t c = 0; c < 4; ++c)
+            difference = std::max(difference, std::abs((int)quadPixels[i + c] - (int)pulledPixels[i + c]));
+        differingPixels += difference > 2;
+        maxDifference = std::max(maxDifference, difference);
+    }
+    std::cout << "smoke: " << glyphs << " glyphs, " << litPixels << " lit pixels, " << differingPixels
+              << " differing (max " << maxDifference << "/255)" << std::endl;
+
+    pulledGlyphs.release();
+    glyphTable.release();
+    quadIndices.release();
+    glDeleteVertexArrays(1, &VAO);
+    glDeleteBuffers(1, &VBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(1, &fbo);
+    glDeleteTextures(1, &colorTexture);
 
-int main()
+    if (!tableCreated || error != GL_NO_ERROR)
+    {
+        std::cout << "ERROR::SMOKE::GL_ERROR: 0x" << std::hex << error << std::dec << std::endl;
+        return 1;
+    }
+    if (litPixels < glyphs * 20 || differingPixels > maxDifferingPixels)
+    {
+        std::cout << "ERROR::SMOKE::PULLED_GLYPHS_DIFFER" << std::endl;
+        return 1;
+    }
+    std::cout << "smoke: passed" << std::endl;
+    return 0;
+}
+
+
+int main(int argc, char* argv[])
 {
+    // offline step: msdf_demo --compile-atlas <page0.json> [<page1.json> ...] <out.atlas>
+    // ------------------------------------------------------------------
+    if (argc >= 4 && strcmp(argv[1], "--compile-atlas") == 0)
+    {
+        std::vector<std::string> jsonPaths(argv + 2, argv + argc - 1);
+        return compileAtlasBinary(jsonPaths, argv[argc - 1]) ? 0 : 1;
+    }
+    // offline step: msdf_demo --pack-texels <image.png> [<image.png> ...]
+    // writes the block-compressed "<image>.blocks", used instead of the PNG
+    // when present: faster to decode, but larger (see msdf_texel_blocks.h).
+    // The bundled pages ship packed: textures/msdf_test2.png, msdf_test.png
+    // ------------------------------------------------------------------
+    if (argc >= 3 && strcmp(argv[1], "--pack-texels") == 0)
+    {
+        for (int i = 2; i < argc; ++i)
+            if (!packTexelBlocksFile(argv[i], texelBlocksPath(argv[i])))
+                return 1;
+        return 0;
+    }
+    // benchmarks: msdf_demo --bench
+    // ------------------------------------------------------------------
+    if (argc == 2 && strcmp(argv[1], "--bench") == 0)
+    {
+        FontId font = fonts.load( "msdf_test2", "textures/msdf_test2.atlas", "textures/msdf_test2.json" );
+        if ( font == FONT_INVALID )
+            return 1;
+        return runBenchmarks(*fonts.font(font));
+    }
+    // smoke test: msdf_demo --smoke
+    // draws vertex pulled glyphs against quads in a hidden window; headless
+    // on Mesa llvmpipe: LIBGL_ALWAYS_SOFTWARE=1 xvfb-run -a ./msdf_demo --smoke
+    // ------------------------------------------------------------------
+    if (argc == 2 && strcmp(argv[1], "--smoke") == 0)
+    {
+        glfwInit();
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#ifdef __APPLE__
+        glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        GLFWwindow* window = glfwCreateWindow(64, 64, "msdf smoke", NULL, NULL);
+        if (window == NULL)
+        {
+            std::cout << "Failed to create GLFW window" << std::endl;
+            glfwTerminate();
+            return 1;
+        }
+        glfwMakeContextCurrent(window);
+        if (!gladLoadGL(glfwGetProcAddress))
+        {
+            std::cout << "Failed to initialize GLAD" << std::endl;
+            glfwTerminate();
+            return 1;
+        }
+        FontId font = fonts.load( "msdf_test2", "textures/msdf_test2.atlas", "textures/msdf_test2.json" );
+        int result = font == FONT_INVALID ? 1 : runSmokeTest(*fonts.font(font));
+        if (font != FONT_INVALID)
+            fonts.font(font)->pages().release();
+        glfwTerminate();
+        return result;
+    }
+
+    // startup: kick off the CPU-only stages on worker threads, they overlap
+    // with window/context creation below and are collected on the GL thread
+    // ------------------------------------------------------------------
+    StartupTimeline timeline;
+
+    // one worker per font: atlas, layout of the font's labels and the texels
+    // of the pages they reference; pages no label uses are never decoded.
+    // Fonts share no mutable state, so the workers run fully in parallel
+    struct FontJob {
+        const char* name;
+        const char* atlasPath;
+        const char* jsonPath;
+        std::vector<Label> labels;
+        FontId font;
+        std::vector<std::pair<uint32_t, TexelImage>> pageTexels;
+    };
+    std::vector<FontJob> jobs(2);
+    jobs[0] = { "msdf_test2", "textures/msdf_test2.atlas", "textures/msdf_test2.json", { { "8", 100, 100, 4.0f, {}, {} } }, FONT_INVALID, {} };
+    jobs[1] = { "msdf_test", "textures/msdf_test.atlas", "msdf_test.json", { { "MTSDF", 100, 700, 1.0f, {}, {} } }, FONT_INVALID, {} };
+
+    std::vector<std::future<bool>> fontsReady;
+    for (FontJob& job : jobs) {
+        fontsReady.push_back(std::async(std::launch::async, [&timeline, &job]() {
+            job.font = timeline.run("font load", [&job]() { return fonts.load(job.name, job.atlasPath, job.jsonPath); });
+            if (job.font == FONT_INVALID)
+                return false;
+            Font& font = *fonts.font(job.font);
+            for (Label& label : job.labels)
+                label.vertices = timeline.run("layout", [&]() { return generateVertexData(font, label.text, label.x, label.y, label.scale, &label.ranges); });
+            for (const Label& label : job.labels)
+                for (const PageRange& range : label.ranges)
+                    if (!font.pages().isResident(range.page))
+                        job.pageTexels.emplace_back(range.page, timeline.run("page texels", [&]() { return font.pages().loadTexels(range.page); }));
+            return true;
+        }));
+    }
+    std::future<ShaderSource> shaderReady = std::async(std::launch::async, [&timeline]() {
+        return timeline.run("shader read", []() {
+            return Shader::readSource("shaders/4.2.texture.vs", "shaders/msdf_text_glow4.frag");
+        });
+    });
+    std::future<ShaderSource> instancedShaderReady = std::async(std::launch::async, [&timeline]() {
+        return timeline.run("shader read", []() {
+            return Shader::readSource("shaders/4.2.texture_instanced.vs", "shaders/msdf_text_glow4.frag");
+        });
+    });
+    std::future<ShaderSource> pulledShaderReady = std::async(std::launch::async, [&timeline]() {
+        return timeline.run("shader read", []() {
+            return Shader::readSource("shaders/4.2.texture_pulled.vs", "shaders/msdf_text_glow4.frag");
+        });
+    });
+    std::future<ShaderSource> compactShaderReady = std::async(std::launch::async, [&timeline]() {
+        return timeline.run("shader read", []() {
+            return Shader::readSource("shaders/4.2.texture_compact.vs", "shaders/msdf_text_glow4.frag");
+        });
+    });
+
     // glfw: initialize and configure
     // ------------------------------
-    glfwInit();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    GLFWwindow* window = timeline.run("window + context", []() -> GLFWwindow* {
+        glfwInit();
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
 #ifdef __APPLE__
-    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+        glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 #endif
 
-    // glfw window creation
-    // --------------------
-    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "LearnOpenGL", NULL, NULL);
+        // glfw window creation
+        // --------------------
+        GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "LearnOpenGL", NULL, NULL);
+        if (window != NULL)
+            glfwMakeContextCurrent(window);
+        return window;
+    });
     if (window == NULL)
     {
         std::cout << "Failed to create GLFW window" << std::endl;
         glfwTerminate();
         return -1;
     }
-    glfwMakeContextCurrent(window);
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
 
     // glad: load all OpenGL function pointers
     // ---------------------------------------
-    if ( !gladLoadGL(glfwGetProcAddress) )
+    if ( !timeline.run("glad load", []() { return gladLoadGL(glfwGetProcAddress); }) )
     {
         std::cout << "Failed to initialize GLAD" << std::endl;
         return -1;
@@ -198,66 +421,242 @@ int main()
 
     // build and compile our shader zprogram
     // ------------------------------------
-    Shader ourShader("shaders/4.2.texture.vs", "shaders/msdf_text_glow4.frag");
+    ShaderSource shaderSource = shaderReady.get();
+    Shader ourShader = timeline.run("shader compile", [&shaderSource]() { return Shader(shaderSource); });
     ourShader.use();
 
     glm::mat4 projection = glm::ortho(0.0f, static_cast<float>(SCR_WIDTH), 0.0f, static_cast<float>(SCR_HEIGHT));
     glUniformMatrix4fv(glGetUniformLocation(ourShader.ID, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
 
-    std::string text = "8";
+    // instanced path: one GlyphInstance record per glyph, expanded by vertex id
+    ShaderSource instancedSource = instancedShaderReady.get();
+    Shader instancedShader = timeline.run("shader compile", [&instancedSource]() { return Shader(instancedSource); });
+    instancedShader.use();
+    glUniformMatrix4fv(glGetUniformLocation(instancedShader.ID, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+    glUniform1i(glGetUniformLocation(instancedShader.ID, "u_msdf"), 0);
+    const float styleColors[INSTANCE_STYLES * 3] = { 1.0f, 1.0f, 1.0f,  1.0f, 0.8f, 0.0f,  1.0f, 0.2f, 0.2f };
+    glUniform3fv(glGetUniformLocation(instancedShader.ID, "styleColors"), (GLsizei)INSTANCE_STYLES, styleColors);
+    GlyphInstanceBuffer glyphInstances;
+    glyphInstances.create();
+
+    // vertex pulling: glyph records only, bounds and UVs from the glyph table
+    ShaderSource pulledSource = pulledShaderReady.get();
+    Shader pulledShader = timeline.run("shader compile", [&pulledSource]() { return Shader(pulledSource); });
+    pulledShader.use();
+    glUniformMatrix4fv(glGetUniformLocation(pulledShader.ID, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+    glUniform1i(glGetUniformLocation(pulledShader.ID, "u_msdf"), 0);
+    glUniform3fv(glGetUniformLocation(pulledShader.ID, "styleColors"), (GLsizei)INSTANCE_STYLES, styleColors);
+    PulledGlyphBuffer pulledGlyphs;
+    pulledGlyphs.create();
+
+    // compact vertices: int16 positions and unorm16 UVs, 12 bytes with color
+    ShaderSource compactSource = compactShaderReady.get();
+    Shader compactShader = timeline.run("shader compile", [&compactSource]() { return Shader(compactSource); });
+    compactShader.use();
+    glUniformMatrix4fv(glGetUniformLocation(compactShader.ID, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+    glUniform1i(glGetUniformLocation(compactShader.ID, "u_msdf"), 0);
+
+    bool fontsLoaded = true;
+    for (std::future<bool>& ready : fontsReady)
+        fontsLoaded = ready.get() && fontsLoaded;
+    if ( !fontsLoaded )
+    {
+        std::cout << "Failed to load atlas" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    // the glyph table of the status line font, uploaded once
+    GlyphTableBuffer glyphTable;
+    if ( !glyphTable.create(fonts.font(jobs[0].font)->glyphs()) )
+    {
+        glfwTerminate();
+        return -1;
+    }
 
-    loadGlyphData( "textures/msdf_test2.json"  );
-    std::vector<float> vertices = generateVertexData(text, 100, 100, 4.0f);
+    // all labels share one vertex buffer, written every frame from the run
+    // cache straight into the frame's stream region: unchanged labels are
+    // only translated to their origin, layout runs for new text only. A draw
+    // is a page range of one font
+    struct FontDraw {
+        FontId font;
+        PageRange range;
+    };
+    std::vector<FontDraw> draws;
+    std::vector<PageRange> labelRanges;
+    // per-frame text goes through the instanced path
+    GlyphInstance* instances = nullptr;
+    size_t instanceCount = 0;
+    std::vector<FontDraw> instanceDraws;
+    // and the status line through vertex pulling, 8 bytes per glyph
+    const float statusScale = 0.2f;
+    PulledGlyph* pulledRecords = nullptr;
+    size_t pulledCount = 0;
+    std::vector<FontDraw> pulledDraws;
+    // the alarm panel wraps to panelWidth; a resize reflows only the
+    // paragraphs that no longer fit on their lines
+    ParagraphLayout alarmPanel(*fonts.font(jobs[0].font), 0.2f, panelWidth);
+    alarmPanel.setText("ALARM 1013: pump 3 discharge pressure above limit, check valve V-12\n"
+                       "WARNING: tank level low\n"
+                       "INFO: operator shift change at 06:00, all panels acknowledged");
+    // a 200k line log scrolling under the alarm panel: only the lines in its
+    // viewport are laid out and emitted, whatever the length of the log
+    VirtualTextView logView(*fonts.font(jobs[0].font), 0.15f);
+    {
+        std::string log;
+        char line[96];
+        for (int i = 0; i < 200000; ++i) {
+            int length = snprintf(line, sizeof(line), "%02d:%02d:%02d.%03d %s pump %d pressure %d hPa\n", i / 360000 % 24,
+                                  i / 6000 % 60, i / 100 % 60, i % 100 * 10, i % 17 ? "INFO" : "WARNING", i % 4 + 1, 990 + i * 7 % 40);
+            log.append(line, (size_t)length);
+        }
+        log.pop_back();
+        logView.setText(log);
+    }
+    frameArena.reserve(64 * 1024);
+    draws.reserve(64);
+    labelRanges.reserve(64);
+    // reflow what changed for this frame; returns the label quads to reserve
+    // in the stream region (a cached run holds at most one quad per byte)
+    auto prepareLabels = [&](float time) {
+        frameArena.reset();
+        alarmPanel.setWidth(panelWidth);
+        alarmPanel.update();
+        logView.setViewport(std::fmod(time * 3.0 * logView.lineHeight(), logView.contentHeight()), 400.0f, panelWidth);
+        logView.update();
+        size_t quads = alarmPanel.quadCount() + logView.visibleQuads();
+        for (const FontJob& job : jobs)
+            for (const Label& label : job.labels)
+                quads += label.text.size();
+        return quads;
+    };
+    // write the labels into `frame`, room for `capacity` quads in this frame's
+    // stream region (nullptr, 0 when there is none); returns the quads written
+    auto buildLabels = [&](float time, float frameMs, float* frame, size_t capacity) {
+        draws.clear();
+        instanceDraws.clear();
+        pulledDraws.clear();
+        size_t written = 0;
+        // hand the rest of the region to `emit`, record its page ranges as draws
+        auto emitLabel = [&](FontId font, size_t maxRanges, auto emit) {
+            labelRanges.resize(maxRanges);
+            LayoutTarget target(frame ? frame + written * LAYOUT_QUAD_FLOATS : nullptr, capacity - written,
+                                labelRanges.data(), maxRanges);
+            size_t quads = emit(target);
+            for (size_t i = 0; i < target.range_count; ++i) {
+                PageRange range = target.ranges[i];
+                range.first += (uint32_t)(written * LAYOUT_QUAD_VERTICES);
+                draws.push_back({ font, range });
+            }
+            written += quads;
+        };
+        for (const FontJob& job : jobs)
+            for (const Label& label : job.labels) {
+                const Font& font = *fonts.font(job.font);
+                const GlyphRun& run = runs.run(job.font, label.text, label.scale, [&](GlyphRun& run) {
+                    run.vertices = generateVertexData(font, label.text, 0.0f, 0.0f, label.scale, &run.ranges);
+                });
+                // the mtsdf label drifts to show the translate-only path
+                float x = label.x + (job.font == jobs[1].font ? 50.0f * sinf(time) : 0.0f);
+                emitLabel(job.font, run.ranges.size(), [&](LayoutTarget& target) {
+                    return GlyphRunCache::emit(run, x, label.y, target);
+                });
+            }
+        emitLabel(jobs[0].font, alarmPanel.rangeCount(), [&](LayoutTarget& target) {
+            return alarmPanel.emit(560.0f, 1000.0f, target);
+        });
+        emitLabel(jobs[0].font, logView.visibleRanges(), [&](LayoutTarget& target) {
+            return logView.emit(560.0f, 600.0f, target);
+        });
+
+        // the frame time changes every frame: no run cache, laid out straight
+        // into the frame arena as instances without touching the heap
+        char frameText[32];
+        int length = snprintf(frameText, sizeof(frameText), "%.2f ms", frameMs);
+        instances = frameArena.allocate<GlyphInstance>((size_t)length);
+        PageRange* frameRanges = frameArena.allocate<PageRange>(4);
+        instanceCount = 0;
+        if (instances && frameRanges) {
+            LayoutTarget target = LayoutTarget::instanced(instances, (size_t)length, frameRanges, 4, 1);
+            instanceCount = layoutText(*fonts.font(jobs[0].font), std::string_view(frameText, (size_t)length), 20.0f, 20.0f, 0.3f, target);
+            for (size_t i = 0; i < target.range_count; ++i)
+                instanceDraws.push_back({ jobs[0].font, target.ranges[i] });
+        }
+
+        char statusText[64];
+        length = snprintf(statusText, sizeof(statusText), "%zu quads, %zu KB of vertices",
+                          written, written * LAYOUT_QUAD_FLOATS * sizeof(float) / 1024);
+        pulledRecords = frameArena.allocate<PulledGlyph>((size_t)length);
+        PageRange* statusRanges = frameArena.allocate<PageRange>(4);
+        pulledCount = 0;
+        if (pulledRecords && statusRanges) {
+            LayoutTarget target = LayoutTarget::pulledGlyphs(pulledRecords, (size_t)length, statusRanges, 4, 2);
+            pulledCount = layoutText(*fonts.font(jobs[0].font), std::string_view(statusText, (size_t)length), 0.0f, 0.0f, statusScale, target);
+            for (size_t i = 0; i < target.range_count; ++i)
+                pulledDraws.push_back({ jobs[0].font, target.ranges[i] });
+        }
+        return written;
+    };
 
-    unsigned int VBO, VAO, EBO;
+    unsigned int VAO;
     glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glGenBuffers(1, &EBO);
 
     glBindVertexArray(VAO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof( float ), vertices.data(), GL_STATIC_DRAW);
-
-    // position attribute
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    // color attribute
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-    // texture coord attribute
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-    glEnableVertexAttribArray(2);
-
-    // load and create a texture
-    // -------------------------
-    unsigned int texture1;
-    // texture 1
-    // ---------
-    glGenTextures(1, &texture1);
-    glBindTexture(GL_TEXTURE_2D, texture1);
-     // set the texture wrapping parameters
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);   // set texture wrapping to GL_REPEAT (default wrapping method)
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    // set texture filtering parameters
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    // load image, create texture and generate mipmaps
-    int width, height, nrChannels;
-    stbi_set_flip_vertically_on_load(true); // tell stb_image.h to flip loaded texture's on the y-axis.
-    // The FileSystem::getPath(...) is part of the GitHub repository so we can find files on any IDE/platform; replace it with your own image path.
-    unsigned char *data = stbi_load("textures/msdf_test2.png", &width, &height, &nrChannels, 0);
-    if (data)
-        {
-        GLenum format = (nrChannels == 4) ? GL_RGBA : (nrChannels == 3) ? GL_RGB : GL_RED;
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        //glGenerateMipmap(GL_TEXTURE_2D);
-        }
-    else
+    // quads are 4 corners each, drawn through one static index buffer
+    QuadIndexBuffer quadIndices;
+    quadIndices.create(4096);
+
+    // the caption never changes: laid out once as compact quads into a
+    // static buffer, drawn at its origin every frame
+    const std::string captionText = "MSDF text demo";
+    const float captionX = 20.0f, captionY = 990.0f;
+    std::vector<unsigned char> captionVertices(captionText.size() * LAYOUT_QUAD_VERTICES * LAYOUT_COMPACT_COLOR_BYTES);
+    PageRange captionRanges[4];
+    LayoutTarget caption = LayoutTarget::compactQuads(captionVertices.data(), captionText.size(), captionRanges, 4, true, 0xFFFFCC00);
+    layoutText(*fonts.font(jobs[0].font), captionText, 0.0f, 0.0f, 0.3f, caption);
+    std::vector<FontDraw> captionDraws;
+    for (size_t i = 0; i < caption.range_count; ++i)
+        captionDraws.push_back({ jobs[0].font, caption.ranges[i] });
+    unsigned int captionVBO;
+    glGenBuffers(1, &captionVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, captionVBO);
+    glBufferData(GL_ARRAY_BUFFER, captionVertices.size(), captionVertices.data(), GL_STATIC_DRAW);
+
+    // the quad vertices are streamed through per-frame regions of one
+    // persistently mapped buffer (unsynchronized mapping without GL 4.4);
+    // the attributes follow this frame's region
+    StreamBuffer vertexStream;
+    if ( !vertexStream.create(256 * 1024, glfwGetProcAddress) )
+    {
+        glfwTerminate();
+        return -1;
+    }
+    auto pointVertices = [&vertexStream](size_t offset) {
+        glBindBuffer(GL_ARRAY_BUFFER, vertexStream.bufferId());
+        // position attribute
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)offset);
+        glEnableVertexAttribArray(0);
+        // color attribute
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(offset + 3 * sizeof(float)));
+        glEnableVertexAttribArray(1);
+        // texture coord attribute
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(offset + 6 * sizeof(float)));
+        glEnableVertexAttribArray(2);
+    };
+
+    // upload the atlas pages referenced by the text, loaded on the worker thread
+    // (mapped from the texel cache on warm starts)
+    // -------------------------------------------------------------------------
+    for (FontJob& job : jobs)
+    {
+        AtlasPages& pages = fonts.font(job.font)->pages();
+        for (auto& loaded : job.pageTexels)
         {
-        std::cout << "Failed to load texture" << std::endl;
+            if (!pages.isResident(loaded.first))
+                timeline.run("page upload", [&]() { pages.upload(loaded.first, loaded.second); });
+            loaded.second.release();
         }
-    stbi_image_free(data);
+        job.pageTexels.clear();
+    }
 
     // tell opengl for each sampler to which texture unit it belongs to (only has to be done once)
     // -------------------------------------------------------------------------------------------
@@ -279,6 +678,8 @@ int main()
 
     // render loop
     // -----------
+    bool timeline_printed = false;
+    double lastFrame = glfwGetTime();
     while (!glfwWindowShouldClose(window))
     {
         // input
@@ -290,28 +691,121 @@ int main()
         glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
         glClear(GL_COLOR_BUFFER_BIT);
 
-        // bind textures on corresponding texture units
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, texture1);
-        //glActiveTexture(GL_TEXTURE1);
-        //glBindTexture(GL_TEXTURE_2D, texture2);
+        // labels: translated from the run cache straight into this frame's
+        // stream region, the uptime clock laid out in place after them
+        double now = glfwGetTime();
+        char clockText[32];
+        int clockLength = snprintf(clockText, sizeof(clockText), "uptime %.3f s", now);
+        const size_t labelQuads = prepareLabels((float)now);
+        const size_t frameBytes = (labelQuads + (size_t)clockLength) * LAYOUT_QUAD_FLOATS * sizeof(float);
+        StreamSpan frameVertices;
+        if (vertexStream.beginFrame(frameBytes))
+            frameVertices = vertexStream.allocate(frameBytes, LAYOUT_VERTEX_FLOATS * sizeof(float));
+        float* frame = static_cast<float*>(frameVertices.data);
+        size_t quadCount = buildLabels((float)now, (float)((now - lastFrame) * 1000.0), frame, frame ? labelQuads : 0);
+        lastFrame = now;
+        if (frame)
+        {
+            PageRange* clockRanges = frameArena.allocate<PageRange>(4);
+            LayoutTarget clock(frame + quadCount * LAYOUT_QUAD_FLOATS, (size_t)clockLength, clockRanges, clockRanges ? 4 : 0);
+            size_t clockGlyphs = layoutText(*fonts.font(jobs[0].font), std::string_view(clockText, (size_t)clockLength), 20.0f, 100.0f, 0.25f, clock);
+            for (size_t i = 0; i < clock.range_count; ++i)
+            {
+                PageRange range = clock.ranges[i];
+                range.first += (uint32_t)(quadCount * LAYOUT_QUAD_VERTICES);
+                draws.push_back({ jobs[0].font, range });
+            }
+            quadCount += clockGlyphs;
+        }
+        vertexStream.flush();
 
         // render container
         ourShader.use();
         glBindVertexArray(VAO);
-        //glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-        glDrawArrays( GL_TRIANGLES, 0, vertices.size() / 8 );
+        pointVertices(frameVertices.offset);
+        quadIndices.reserve(quadCount);
+        glActiveTexture(GL_TEXTURE0);
+        for (const FontDraw& draw : draws)
+        {
+            // bind the page texture of the font, loading the page on its first use
+            AtlasPages& pages = fonts.font(draw.font)->pages();
+            if (!pages.require(draw.range.page))
+                continue;
+            glBindTexture(GL_TEXTURE_2D, pages.texture(draw.range.page));
+            quadIndices.draw(draw.range);
+        }
+        instancedShader.use();
+        glyphInstances.upload(instances, instanceCount);
+        glyphInstances.bind(instancedShader.ID);
+        for (const FontDraw& draw : instanceDraws)
+        {
+            AtlasPages& pages = fonts.font(draw.font)->pages();
+            if (!pages.require(draw.range.page))
+                continue;
+            glBindTexture(GL_TEXTURE_2D, pages.texture(draw.range.page));
+            glyphInstances.draw(draw.range);
+        }
+        pulledShader.use();
+        pulledGlyphs.upload(pulledRecords, pulledCount);
+        pulledGlyphs.bind(pulledShader.ID, glyphTable);
+        pulledGlyphOrigin(pulledShader.ID, glyphTable, 20.0f, 60.0f, statusScale);
+        for (const FontDraw& draw : pulledDraws)
+        {
+            AtlasPages& pages = fonts.font(draw.font)->pages();
+            if (!pages.require(draw.range.page))
+                continue;
+            glBindTexture(GL_TEXTURE_2D, pages.texture(draw.range.page));
+            pulledGlyphs.draw(draw.range);
+        }
+        compactShader.use();
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, captionVBO);
+        compactVertexAttributes(true);
+        compactVertexOrigin(compactShader.ID, captionX, captionY);
+        for (const FontDraw& draw : captionDraws)
+        {
+            AtlasPages& pages = fonts.font(draw.font)->pages();
+            if (!pages.require(draw.range.page))
+                continue;
+            glBindTexture(GL_TEXTURE_2D, pages.texture(draw.range.page));
+            quadIndices.draw(draw.range);
+        }
+        vertexStream.endFrame();
         // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
         // -------------------------------------------------------------------------------
         glfwSwapBuffers(window);
         glfwPollEvents();
+
+        if (!timeline_printed)
+        {
+            timeline.mark("first frame");
+            timeline.print();
+            for (FontId id = 0; id < fonts.fontCount(); ++id)
+            {
+                std::cout << "font " << id << " " << fonts.font(id)->name() << std::endl;
+                fonts.font(id)->pages().printResidency();
+            }
+            timeline_printed = true;
+        }
     }
 
+    std::cout << "glyph run cache: " << runs.hits() << " hits, " << runs.misses() << " misses, "
+              << runs.evictions() << " evictions, " << runs.entryCount() << " runs in " << runs.bytes() / 1024
+              << " KB of " << runs.budget() / 1024 << " KB" << std::endl;
+    std::cout << "vertex stream: " << (vertexStream.persistent() ? "persistent" : "unsynchronized") << ", "
+              << vertexStream.regionBytes() / 1024 << " KB regions, " << vertexStream.waits() << " waits, "
+              << vertexStream.orphans() << " orphans" << std::endl;
+
     // optional: de-allocate all resources once they've outlived their purpose:
     // ------------------------------------------------------------------------
     glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
-    glDeleteBuffers(1, &EBO);
+    glDeleteBuffers(1, &captionVBO);
+    vertexStream.release();
+    quadIndices.release();
+    glyphInstances.release();
+    pulledGlyphs.release();
+    glyphTable.release();
+    fonts.release();
 
     // glfw: terminate, clearing all previously allocated GLFW resources.
     // ------------------------------------------------------------------
@@ -334,4 +828,5 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height)
     // make sure the viewport matches the new window dimensions; note that width and
     // height will be significantly larger than specified on retina displays.
     glViewport(0, 0, width, height);
+    panelWidth = width * 0.4f;
 }
\ No newline at end of file
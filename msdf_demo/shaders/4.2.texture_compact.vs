@@ -0,0 +1,20 @@
+#version 330 core
+// compact variant of 4.2.texture.vs: int16 positions relative to the label
+// origin, unorm16 texcoords and an optional RGBA8 color
+layout (location = 0) in vec2 aPos;
+layout (location = 1) in vec4 aColor;
+layout (location = 2) in vec2 aTexCoord;
+
+out vec3 ourColor;
+out vec2 texCoord;
+
+uniform mat4 projection;
+uniform vec2 labelOrigin;
+uniform float positionStep;
+
+void main()
+{
+	gl_Position =  projection * vec4(labelOrigin + aPos * positionStep, 0.0, 1.0);
+	ourColor = aColor.rgb;
+	texCoord = aTexCoord;
+}
@@ -0,0 +1,29 @@
+#version 330 core
+// instanced variant of 4.2.texture.vs: one GlyphInstance record per glyph
+// (screen rect, atlas UV rect, style; 9 R32UI texels), drawn through the
+// quad index buffer: gl_VertexID >> 2 is the record, gl_VertexID & 3 the
+// unit quad corner that picks the screen and atlas corner of its rects
+uniform usamplerBuffer glyphInstances;
+
+out vec3 ourColor;
+out vec2 texCoord;
+
+uniform mat4 projection;
+uniform vec3 styleColors[8];
+
+float recordFloat(int texel)
+{
+	return uintBitsToFloat(texelFetch(glyphInstances, texel).r);
+}
+
+void main()
+{
+	int base = (gl_VertexID >> 2) * 9;
+	vec4 rect = vec4(recordFloat(base), recordFloat(base + 1), recordFloat(base + 2), recordFloat(base + 3));
+	vec4 uvRect = vec4(recordFloat(base + 4), recordFloat(base + 5), recordFloat(base + 6), recordFloat(base + 7));
+	uint style = texelFetch(glyphInstances, base + 8).r;
+	vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1 & 1);
+	gl_Position =  projection * vec4(mix(rect.xy, rect.zw, corner), 0.0, 1.0);
+	ourColor = styleColors[style & 7u];
+	texCoord = mix(uvRect.xy, uvRect.zw, corner);
+}
@@ -0,0 +1,30 @@
+#version 330 core
+// vertex pulling variant of 4.2.texture.vs, no vertex attributes: instance i
+// is glyph record firstGlyph + i (pen x, glyph index | style << 16), the
+// glyph index is the row of the font's glyph table and gl_VertexID the
+// corner of the 4 vertex triangle strip
+uniform samplerBuffer glyphTable;       // per glyph: plane bounds in planeUnit steps, UV rect
+uniform usamplerBuffer glyphRecords;    // RG32UI PulledGlyph records
+
+out vec3 ourColor;
+out vec2 texCoord;
+
+uniform mat4 projection;
+uniform vec3 styleColors[8];
+uniform int firstGlyph;
+uniform vec2 labelOrigin;
+uniform float planeScale;               // planeUnit times the label scale
+
+void main()
+{
+	uvec2 record = texelFetch(glyphRecords, firstGlyph + gl_InstanceID).xy;
+	int glyph = int(record.y & 0xFFFFu);
+	vec4 bounds = texelFetch(glyphTable, 2 * glyph);
+	vec4 uvRect = texelFetch(glyphTable, 2 * glyph + 1);
+	vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+	vec2 pen = vec2(labelOrigin.x + uintBitsToFloat(record.x), labelOrigin.y);
+	vec4 rect = pen.xyxy + bounds * planeScale;
+	gl_Position =  projection * vec4(mix(rect.xy, rect.zw, corner), 0.0, 1.0);
+	ourColor = styleColors[(record.y >> 16) & 7u];
+	texCoord = mix(uvRect.xy, uvRect.zw, corner);
+}